@@ -25,8 +25,12 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "../utils.hpp"
 #include "rapidjson/include/rapidjson/document.h"
@@ -75,6 +79,218 @@ struct tick {
     } marketDepth;
 };
 
+/// Subscription mode a `compactTick` was sent in.
+enum class TICK_MODE : uint8_t
+{
+    LTP,
+    QUOTE,
+    FULL
+};
+
+///
+/// @brief Represents a single market data tick, like `tick`, but without any
+///        heap allocated members. It is trivially copyable, so ticks can be
+///        kept in flat buffers and copied with `memcpy`.
+///
+/// Fields sent in LTP mode come first and, along with the rest of the quote
+/// fields, fill the first cache line. OHLC, OI and market depth follow.
+///
+struct alignas(64) compactTick {
+    static constexpr size_t DEPTH_ENTRIES_PER_SIDE = 5;
+
+    // hot: ltp & quote
+    int32_t instrumentToken = -1;
+    TICK_MODE mode = TICK_MODE::LTP;
+    bool isTradable = false;
+    double lastPrice = -1;
+    int32_t lastTradedQuantity = -1;
+    int32_t volumeTraded = -1;
+    double averageTradePrice = -1;
+    int32_t totalBuyQuantity = -1;
+    int32_t totalSellQuantity = -1;
+    double netChange = -1;
+    int32_t timestamp = -1;
+    int32_t lastTradeTime = -1;
+    // cold: ohlc, oi & full
+    tick::OHLC ohlc;
+    int32_t oi = -1;
+    int32_t oiDayHigh = -1;
+    int32_t oiDayLow = -1;
+    struct m_depth {
+        std::array<depthWS, DEPTH_ENTRIES_PER_SIDE> buy;
+        std::array<depthWS, DEPTH_ENTRIES_PER_SIDE> sell;
+    } marketDepth;
+};
+static_assert(std::is_trivially_copyable_v<compactTick>);
+static_assert(std::is_standard_layout_v<compactTick>);
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+static_assert(offsetof(compactTick, lastTradeTime) + sizeof(int32_t) <= 64,
+    "ltp & quote fields should fit in the first cache line");
+
+///
+/// @brief Ticks of a single message stored column-wise, i.e., field `x` of the
+///        `i`th tick is `x[i]`. Loops over a column run over contiguous
+///        memory and can be vectorized by the compiler.
+///
+/// Fields that aren't sent in a tick's mode are set to `-1`, as in
+/// `compactTick`. Market depth is stored as a column per level, e.g.,
+/// `buyPrice[0][i]` is the best bid of the `i`th tick.
+///
+struct tickBatch {
+    static constexpr size_t DEPTH_ENTRIES_PER_SIDE = 5;
+    template <class T>
+    using depthColumns = std::array<std::vector<T>, DEPTH_ENTRIES_PER_SIDE>;
+
+    std::vector<int32_t> instrumentToken;
+    std::vector<TICK_MODE> mode;
+    std::vector<uint8_t> isTradable;
+    std::vector<double> lastPrice;
+    std::vector<int32_t> lastTradedQuantity;
+    std::vector<int32_t> volumeTraded;
+    std::vector<double> averageTradePrice;
+    std::vector<int32_t> totalBuyQuantity;
+    std::vector<int32_t> totalSellQuantity;
+    std::vector<double> netChange;
+    std::vector<int32_t> timestamp;
+    std::vector<int32_t> lastTradeTime;
+    std::vector<double> open;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> close;
+    std::vector<int32_t> oi;
+    std::vector<int32_t> oiDayHigh;
+    std::vector<int32_t> oiDayLow;
+    depthColumns<double> buyPrice;
+    depthColumns<int32_t> buyQuantity;
+    depthColumns<int16_t> buyOrders;
+    depthColumns<double> sellPrice;
+    depthColumns<int32_t> sellQuantity;
+    depthColumns<int16_t> sellOrders;
+
+    /// @brief Get the number of ticks in the batch.
+    size_t size() const { return instrumentToken.size(); };
+
+    /// @brief Check whether the batch is empty.
+    bool empty() const { return instrumentToken.empty(); };
+
+    /// @brief Resize all columns to hold \a Size ticks.
+    void resize(size_t Size) {
+        forEachColumn([Size](auto& column) { column.resize(Size); });
+    };
+
+    /// @brief Call \a fn with each column.
+    template <class Fn>
+    void forEachColumn(Fn&& fn) {
+        fn(instrumentToken);
+        fn(mode);
+        fn(isTradable);
+        fn(lastPrice);
+        fn(lastTradedQuantity);
+        fn(volumeTraded);
+        fn(averageTradePrice);
+        fn(totalBuyQuantity);
+        fn(totalSellQuantity);
+        fn(netChange);
+        fn(timestamp);
+        fn(lastTradeTime);
+        fn(open);
+        fn(high);
+        fn(low);
+        fn(close);
+        fn(oi);
+        fn(oiDayHigh);
+        fn(oiDayLow);
+        for (size_t level = 0; level < DEPTH_ENTRIES_PER_SIDE; level++) {
+            fn(buyPrice[level]);
+            fn(buyQuantity[level]);
+            fn(buyOrders[level]);
+            fn(sellPrice[level]);
+            fn(sellQuantity[level]);
+            fn(sellOrders[level]);
+        };
+    };
+};
+
+/// Represents a single entry in market depth of a `fixedTick`.
+struct fixedDepthWS {
+    int16_t orders = -1;
+    int32_t quantity = -1;
+    int32_t price = -1;
+};
+
+///
+/// @brief Convert a fixed-point price to a `double`.
+///
+/// @param price    price in units of 10^\a exponent
+/// @param exponent scale exponent of \a price, between -9 and 0
+///
+/// @return double price
+///
+inline double fromFixedPoint(int32_t price, int8_t exponent) {
+    static constexpr std::array<double, 10> DIVISORS = { 1e0, 1e1, 1e2, 1e3,
+        1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    return price / DIVISORS.at(-exponent);
+};
+
+///
+/// @brief Represents a single market data tick, like `compactTick`, but with
+///        prices left as the integers sent by the exchange.
+///
+/// A price `p` in a `fixedTick` stands for `p * 10^priceExponent` rupees (or
+/// the instrument's quote currency). `price()` converts it when needed, so
+/// comparing and adding prices stays exact and doesn't need floating point.
+///
+struct alignas(64) fixedTick {
+    static constexpr size_t DEPTH_ENTRIES_PER_SIDE = 5;
+
+    // hot: ltp & quote
+    int32_t instrumentToken = -1;
+    TICK_MODE mode = TICK_MODE::LTP;
+    bool isTradable = false;
+    int8_t priceExponent = 0;
+    int32_t lastPrice = -1;
+    int32_t lastTradedQuantity = -1;
+    int32_t volumeTraded = -1;
+    int32_t averageTradePrice = -1;
+    int32_t totalBuyQuantity = -1;
+    int32_t totalSellQuantity = -1;
+    /// Absolute change from the previous close, unlike `compactTick`'s
+    /// `netChange` which is a percentage for tradable instruments.
+    int32_t netChange = -1;
+    int32_t timestamp = -1;
+    int32_t lastTradeTime = -1;
+    // cold: ohlc, oi & full
+    struct OHLC {
+        int32_t open = -1;
+        int32_t high = -1;
+        int32_t low = -1;
+        int32_t close = -1;
+    } ohlc;
+    int32_t oi = -1;
+    int32_t oiDayHigh = -1;
+    int32_t oiDayLow = -1;
+    struct m_depth {
+        std::array<fixedDepthWS, DEPTH_ENTRIES_PER_SIDE> buy;
+        std::array<fixedDepthWS, DEPTH_ENTRIES_PER_SIDE> sell;
+    } marketDepth;
+
+    /// @brief Convert \a Price, a price of this tick, to a `double`.
+    double price(int32_t Price) const {
+        return fromFixedPoint(Price, priceExponent);
+    };
+
+    /// @brief Get `netChange` as a percentage of the previous close.
+    double netChangePercent() const {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        return static_cast<double>(netChange) * 100 / ohlc.close;
+    };
+};
+static_assert(std::is_trivially_copyable_v<fixedTick>);
+static_assert(std::is_standard_layout_v<fixedTick>);
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+static_assert(offsetof(fixedTick, lastTradeTime) + sizeof(int32_t) <= 64,
+    "ltp & quote fields should fit in the first cache line");
+
 /// Represents a postback.
 struct postback {
     postback() = default;
@@ -0,0 +1,83 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace kiteconnect {
+
+///
+/// @brief Non-owning view of a contiguous sequence of \a T, like C++20's
+///        `std::span`.
+///
+/// @tparam T element type
+///
+template <class T>
+class span {
+
+  public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = size_t;
+    using iterator = T*;
+
+    constexpr span() noexcept = default;
+
+    constexpr span(T* Data, size_t Size) noexcept: Data(Data), Size(Size) {};
+
+    /// @brief View the first \a Size elements of \a vec.
+    span(const std::vector<value_type>& vec, size_t Size) noexcept
+        : Data(vec.data()), Size(Size) {};
+
+    /// @brief View all elements of \a vec.
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    span(const std::vector<value_type>& vec) noexcept
+        : span(vec, vec.size()) {};
+
+    constexpr T* data() const noexcept { return Data; };
+
+    constexpr size_t size() const noexcept { return Size; };
+
+    constexpr bool empty() const noexcept { return Size == 0; };
+
+    constexpr T& operator[](size_t idx) const { return Data[idx]; };
+
+    constexpr T& front() const { return Data[0]; };
+
+    constexpr T& back() const { return Data[Size - 1]; };
+
+    constexpr iterator begin() const noexcept { return Data; };
+
+    constexpr iterator end() const noexcept { return Data + Size; };
+
+  private:
+    T* Data = nullptr;
+    size_t Size = 0;
+};
+
+} // namespace kiteconnect
@@ -25,5 +25,20 @@
 
 #pragma once
 
+#include "ticker/binary.hpp"
+#include "ticker/cache.hpp"
+#include "ticker/control.hpp"
+#include "ticker/encoder.hpp"
 #include "ticker/internal.hpp"
+#include "ticker/multicast.hpp"
+#include "ticker/orders.hpp"
+#include "ticker/parser.hpp"
+#include "ticker/pool.hpp"
+#include "ticker/postback.hpp"
+#include "ticker/redundant.hpp"
+#include "ticker/ring.hpp"
+#include "ticker/shards.hpp"
+#include "ticker/shm.hpp"
+#include "ticker/simd.hpp"
+#include "ticker/subscriptions.hpp"
 #include "ticker/ws.hpp"
\ No newline at end of file
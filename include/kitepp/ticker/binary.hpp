@@ -0,0 +1,330 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib> //_byteswap_*
+#include <cstring> //memcpy
+#include <iterator>
+#include <type_traits>
+
+#include "../exceptions.hpp"
+#include "../utils.hpp"
+
+namespace kiteconnect::internal::binary {
+
+using std::string;
+namespace kc = kiteconnect;
+
+enum class SEGMENTS : int
+{
+    NSE = 1,
+    NFO,
+    CDS,
+    BSE,
+    BFO,
+    BSECDS,
+    MCX,
+    MCXSX,
+    INDICES
+};
+
+/// Size of the length prefix of frames and packets.
+constexpr size_t LENGTH_SIZE = 2;
+
+/// @brief Reverse the byte order of \a value.
+template <typename T>
+T byteSwap(T value) {
+    static_assert(std::is_unsigned_v<T>, "T must be an unsigned integer");
+    // clang-format off
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else if constexpr (sizeof(T) == 2) {
+        #if defined(_MSC_VER)
+        return _byteswap_ushort(value);
+        #else
+        return __builtin_bswap16(value);
+        #endif
+    } else if constexpr (sizeof(T) == 4) {
+        #if defined(_MSC_VER)
+        return _byteswap_ulong(value);
+        #else
+        return __builtin_bswap32(value);
+        #endif
+    } else {
+        static_assert(sizeof(T) == 8, "unsupported integer size");
+        #if defined(_MSC_VER)
+        return _byteswap_uint64(value);
+        #else
+        return __builtin_bswap64(value);
+        #endif
+    }
+    // clang-format on
+};
+
+///
+/// @brief Read a big-endian value of type \a T starting at \a bytes. Compiles
+///        down to a single load and byte swap.
+///
+template <typename T>
+T unpack(const char* bytes) {
+    using Raw = std::make_unsigned_t<T>;
+    Raw raw = 0;
+    std::memcpy(&raw, bytes, sizeof(T));
+
+    // clang-format off
+    #ifndef WORDS_BIGENDIAN
+    raw = byteSwap(raw);
+    #endif
+    // clang-format on
+
+    return static_cast<T>(raw);
+};
+
+/// @brief Write \a value starting at \a bytes in big-endian byte order. The
+///        inverse of `unpack()`.
+template <typename T>
+void pack(char* bytes, T value) {
+    using Raw = std::make_unsigned_t<T>;
+    auto raw = static_cast<Raw>(value);
+
+    // clang-format off
+    #ifndef WORDS_BIGENDIAN
+    raw = byteSwap(raw);
+    #endif
+    // clang-format on
+
+    std::memcpy(bytes, &raw, sizeof(T));
+};
+
+/// Byte offsets of packet fields. Packets are told apart by their size.
+namespace layout {
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+struct ltp {
+    static constexpr size_t SIZE = 8;
+    static constexpr size_t INSTRUMENT_TOKEN = 0;
+    static constexpr size_t LAST_PRICE = 4;
+};
+
+struct indicesQuote {
+    static constexpr size_t SIZE = 28;
+    static constexpr size_t INSTRUMENT_TOKEN = 0;
+    static constexpr size_t LAST_PRICE = 4;
+    static constexpr size_t HIGH = 8;
+    static constexpr size_t LOW = 12;
+    static constexpr size_t OPEN = 16;
+    static constexpr size_t CLOSE = 20;
+    static constexpr size_t NET_CHANGE = 24;
+};
+
+struct indicesFull : indicesQuote {
+    static constexpr size_t SIZE = 32;
+    static constexpr size_t TIMESTAMP = 28;
+};
+
+struct quote {
+    static constexpr size_t SIZE = 44;
+    static constexpr size_t INSTRUMENT_TOKEN = 0;
+    static constexpr size_t LAST_PRICE = 4;
+    static constexpr size_t LAST_TRADED_QUANTITY = 8;
+    static constexpr size_t AVERAGE_TRADE_PRICE = 12;
+    static constexpr size_t VOLUME_TRADED = 16;
+    static constexpr size_t TOTAL_BUY_QUANTITY = 20;
+    static constexpr size_t TOTAL_SELL_QUANTITY = 24;
+    static constexpr size_t OPEN = 28;
+    static constexpr size_t HIGH = 32;
+    static constexpr size_t LOW = 36;
+    static constexpr size_t CLOSE = 40;
+};
+
+struct full : quote {
+    static constexpr size_t SIZE = 184;
+    static constexpr size_t LAST_TRADE_TIME = 44;
+    static constexpr size_t OI = 48;
+    static constexpr size_t OI_DAY_HIGH = 52;
+    static constexpr size_t OI_DAY_LOW = 56;
+    static constexpr size_t TIMESTAMP = 60;
+    static constexpr size_t DEPTH = 64;
+    static constexpr size_t DEPTH_ENTRIES = 10;
+    static constexpr size_t DEPTH_ENTRY_SIZE = 12;
+    // offsets within a depth entry
+    static constexpr size_t DEPTH_QUANTITY = 0;
+    static constexpr size_t DEPTH_PRICE = 4;
+    static constexpr size_t DEPTH_ORDERS = 8;
+};
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+static_assert(full::DEPTH + full::DEPTH_ENTRIES * full::DEPTH_ENTRY_SIZE ==
+              full::SIZE);
+} // namespace layout
+
+/// Non-owning, bounds-checked view of a single packet of a binary message.
+class packetView {
+  public:
+    packetView() = default;
+
+    packetView(const char* Data, size_t Size): Data(Data), Size(Size) {};
+
+    [[nodiscard]] const char* data() const { return Data; };
+
+    [[nodiscard]] size_t size() const { return Size; };
+
+    ///
+    /// @brief Read the big-endian field of type \a T at \a offset.
+    ///
+    /// @throws kc::libException if the field lies outside the packet
+    ///
+    template <typename T>
+    [[nodiscard]] T get(size_t offset) const {
+        if (offset + sizeof(T) > Size) {
+            throw kc::libException(FMT(
+                "field at offset {0} is out of bounds of packet of size {1}",
+                offset, Size));
+        };
+        return unpack<T>(Data + offset);
+    };
+
+    ///
+    /// @brief Read the big-endian field of type \a T at compile-time offset
+    ///        \a Offset of a packet laid out as \a Layout. Bounds are checked
+    ///        at compile time, so the caller must have matched the packet's
+    ///        size against `Layout::SIZE`.
+    ///
+    template <class Layout, size_t Offset, typename T = int32_t>
+    [[nodiscard]] T field() const {
+        static_assert(Offset + sizeof(T) <= Layout::SIZE,
+            "field lies outside the packet layout");
+        return unpack<T>(Data + Offset);
+    };
+
+  private:
+    const char* Data = nullptr;
+    size_t Size = 0;
+};
+
+///
+/// @brief Non-owning view of a binary message. Packets are walked in place,
+///        directly over the buffer handed over by the websocket library, so
+///        iterating doesn't copy or allocate.
+///
+class frameView {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = packetView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const packetView*;
+        using reference = const packetView&;
+
+        iterator() = default;
+
+        iterator(const char* Bytes, size_t Size, size_t Remaining)
+            : bytes(Bytes), size(Size), remaining(Remaining) {
+            if (remaining > 0) { read(); };
+        };
+
+        reference operator*() const { return packet; };
+
+        pointer operator->() const { return &packet; };
+
+        iterator& operator++() {
+            offset += LENGTH_SIZE + packet.size();
+            remaining--;
+            if (remaining > 0) { read(); };
+            return *this;
+        };
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++(*this);
+            return old;
+        };
+
+        bool operator==(const iterator& other) const {
+            return remaining == other.remaining;
+        };
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        };
+
+      private:
+        void read() {
+            if (offset + LENGTH_SIZE > size) {
+                throw kc::libException("binary message is truncated");
+            };
+            const auto packetLength = unpack<int16_t>(bytes + offset);
+            if (packetLength < 0 ||
+                offset + LENGTH_SIZE + static_cast<size_t>(packetLength) >
+                    size) {
+                throw kc::libException("binary message is truncated");
+            };
+            packet = packetView(bytes + offset + LENGTH_SIZE,
+                static_cast<size_t>(packetLength));
+        };
+
+        const char* bytes = nullptr;
+        size_t size = 0;
+        size_t remaining = 0;
+        size_t offset = LENGTH_SIZE;
+        packetView packet;
+    };
+
+    ///
+    /// @brief Construct a view of the binary message \a Bytes of \a Size
+    ///        bytes.
+    ///
+    /// @throws kc::libException if the message is too short to contain a
+    ///         packet count
+    ///
+    frameView(const char* Bytes, size_t Size): bytes(Bytes), Size(Size) {
+        if (Size < LENGTH_SIZE) {
+            throw kc::libException("binary message is truncated");
+        };
+        const auto count = unpack<int16_t>(bytes);
+        numberOfPackets = (count > 0) ? static_cast<size_t>(count) : 0;
+    };
+
+    /// @brief Number of packets the message claims to carry.
+    [[nodiscard]] size_t size() const { return numberOfPackets; };
+
+    [[nodiscard]] bool empty() const { return numberOfPackets == 0; };
+
+    [[nodiscard]] iterator begin() const {
+        return { bytes, Size, numberOfPackets };
+    };
+
+    [[nodiscard]] iterator end() const { return {}; };
+
+  private:
+    const char* bytes = nullptr;
+    size_t Size = 0;
+    size_t numberOfPackets = 0;
+};
+
+} // namespace kiteconnect::internal::binary
@@ -0,0 +1,208 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../span.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+///
+/// @brief Keeps the latest tick of every instrument, conflating older ones.
+///        Written by a single thread and read by any number of threads,
+///        without locks.
+///
+/// Instruments are assigned a slot in an open addressing table the first
+/// time they are seen; slots are never freed. Every slot is guarded by a
+/// sequence lock: readers copy the tick and retry if the writer updated it
+/// in the meantime, so reads never block the writer.
+///
+class lastValueCache {
+
+  public:
+    ///
+    /// @brief Construct a new cache.
+    ///
+    /// @param MaxInstruments maximum number of instruments the cache can hold.
+    ///                       Ticks of further instruments are dropped and
+    ///                       counted by `getDropped()`.
+    ///
+    explicit lastValueCache(size_t MaxInstruments)
+        : maxInstruments(MaxInstruments) {
+        if (MaxInstruments == 0) {
+            throw kc::libException("cache must hold at least one instrument");
+        };
+        // keep the load factor at 0.5 or below so probes stay short
+        while (tableSize < MaxInstruments * 2) { tableSize <<= 1U; };
+        keys = std::make_unique<std::atomic<int32_t>[]>(tableSize);
+        for (size_t i = 0; i < tableSize; i++) {
+            keys[i].store(EMPTY, std::memory_order_relaxed);
+        };
+        slots = std::make_unique<slot[]>(tableSize);
+    };
+
+    lastValueCache(const lastValueCache&) = delete;
+    lastValueCache& operator=(const lastValueCache&) = delete;
+
+    /// @brief Store \a tick as the latest tick of its instrument. Should only
+    ///        be called by one thread.
+    void update(const kc::compactTick& tick) {
+        if (tick.instrumentToken == EMPTY) { return; };
+        size_t idx = home(tick.instrumentToken);
+        while (true) {
+            const int32_t key = keys[idx].load(std::memory_order_relaxed);
+            if (key == tick.instrumentToken) {
+                write(slots[idx], tick);
+                return;
+            };
+            if (key == EMPTY) {
+                if (instruments.load(std::memory_order_relaxed) ==
+                    maxInstruments) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                };
+                write(slots[idx], tick);
+                // publishes the slot along with its first tick
+                keys[idx].store(
+                    tick.instrumentToken, std::memory_order_release);
+                instruments.fetch_add(1, std::memory_order_relaxed);
+                return;
+            };
+            idx = (idx + 1) & (tableSize - 1);
+        };
+    };
+
+    /// @brief Store each of \a ticks as the latest tick of its instrument.
+    void update(kc::span<const kc::compactTick> ticks) {
+        for (const kc::compactTick& tick : ticks) { update(tick); };
+    };
+
+    ///
+    /// @brief Get the latest tick of \a instrumentToken. Can be called by any
+    ///        thread.
+    ///
+    /// @param instrumentToken instrument token
+    /// @param tick            set to a consistent copy of the latest tick
+    ///
+    /// @return bool `false` if no tick of \a instrumentToken was seen yet
+    ///
+    bool get(int32_t instrumentToken, kc::compactTick& tick) const {
+        size_t idx = home(instrumentToken);
+        for (size_t probes = 0; probes < tableSize; probes++) {
+            const int32_t key = keys[idx].load(std::memory_order_acquire);
+            if (key == instrumentToken) {
+                read(slots[idx], tick);
+                return true;
+            };
+            if (key == EMPTY) { return false; };
+            idx = (idx + 1) & (tableSize - 1);
+        };
+        return false;
+    };
+
+    /// @brief Get the number of instruments in the cache.
+    size_t getSize() const {
+        return instruments.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the number of ticks dropped because the cache was full.
+    uint64_t getDropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    };
+
+  private:
+    static constexpr int32_t EMPTY = std::numeric_limits<int32_t>::min();
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t WORDS =
+        (sizeof(kc::compactTick) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // ticks are copied word by word through atomics; a plain memcpy racing
+    // with the writer would be a data race, even though torn copies are
+    // thrown away
+    struct alignas(CACHE_LINE_SIZE) slot {
+        std::atomic<uint64_t> sequence { 0 };
+        std::array<std::atomic<uint64_t>, WORDS> words {};
+    };
+
+    const size_t maxInstruments;
+    size_t tableSize = 1;
+    std::unique_ptr<std::atomic<int32_t>[]> keys;
+    std::unique_ptr<slot[]> slots;
+    std::atomic<size_t> instruments { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+
+    size_t home(int32_t instrumentToken) const {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        const uint64_t hash = static_cast<uint32_t>(instrumentToken) *
+                              0x9e3779b97f4a7c15ULL;
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        return static_cast<size_t>(hash >> 32U) & (tableSize - 1);
+    };
+
+    static void write(slot& Slot, const kc::compactTick& tick) {
+        std::array<uint64_t, WORDS> words {};
+        std::memcpy(words.data(), &tick, sizeof(kc::compactTick));
+        const uint64_t sequence =
+            Slot.sequence.load(std::memory_order_relaxed);
+        // odd while writing
+        Slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            Slot.words[i].store(words[i], std::memory_order_relaxed);
+        };
+        Slot.sequence.store(sequence + 2, std::memory_order_release);
+    };
+
+    static void read(const slot& Slot, kc::compactTick& tick) {
+        std::array<uint64_t, WORDS> words {};
+        while (true) {
+            const uint64_t before =
+                Slot.sequence.load(std::memory_order_acquire);
+            if ((before & 1U) != 0) { continue; };
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = Slot.words[i].load(std::memory_order_relaxed);
+            };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Slot.sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            };
+        };
+        std::memcpy(static_cast<void*>(&tick), words.data(), sizeof(tick));
+    };
+};
+
+} // namespace kiteconnect
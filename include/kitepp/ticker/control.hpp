@@ -0,0 +1,191 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../userconstants.hpp"
+
+namespace kiteconnect::internal {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// @brief Collects subscription changes, merges them & turns them into as
+///        few control frames as possible, sent at a limited rate.
+///
+/// Changes to the same instrument cancel out, e.g., subscribing & then
+/// unsubscribing only unsubscribes, and only the last mode set is sent.
+/// Frames are sent in the order unsubscribe, subscribe & mode.
+///
+class controlQueue {
+
+  public:
+    static constexpr size_t DEFAULT_MAX_TOKENS_PER_FRAME = 1000;
+    static constexpr unsigned int DEFAULT_MAX_FRAMES_PER_SECOND = 10;
+
+    explicit controlQueue(
+        size_t MaxTokensPerFrame = DEFAULT_MAX_TOKENS_PER_FRAME,
+        unsigned int MaxFramesPerSecond = DEFAULT_MAX_FRAMES_PER_SECOND) {
+        setLimits(MaxTokensPerFrame, MaxFramesPerSecond);
+    };
+
+    void setLimits(size_t MaxTokensPerFrame, unsigned int MaxFramesPerSecond) {
+        if (MaxTokensPerFrame == 0 || MaxFramesPerSecond == 0) {
+            throw kc::libException("control frame limits can't be 0");
+        };
+        maxTokensPerFrame = MaxTokensPerFrame;
+        maxFramesPerSecond = MaxFramesPerSecond;
+    };
+
+    void subscribe(const std::vector<int>& instrumentTokens) {
+        for (const int token : instrumentTokens) {
+            // still subscribed on the server, in whatever mode it had
+            if (unsubscribed.erase(token) == 1) { modes[token] = MODE_QUOTE; };
+            subscribed.insert(token);
+        };
+    };
+
+    void unsubscribe(const std::vector<int>& instrumentTokens) {
+        for (const int token : instrumentTokens) {
+            subscribed.erase(token);
+            modes.erase(token);
+            unsubscribed.insert(token);
+        };
+    };
+
+    void setMode(const string& mode, const std::vector<int>& instrumentTokens) {
+        for (const int token : instrumentTokens) { modes[token] = mode; };
+    };
+
+    /// @brief Drop pending changes & frames, e.g., once disconnected.
+    void clear() {
+        subscribed.clear();
+        unsubscribed.clear();
+        modes.clear();
+        frames.clear();
+    };
+
+    /// @brief Check if there is nothing left to send.
+    bool empty() const {
+        return subscribed.empty() && unsubscribed.empty() && modes.empty() &&
+               frames.empty();
+    };
+
+    ///
+    /// @brief Turn pending changes into frames & pass as many of them to
+    ///        \a send as the rate limit allows.
+    ///
+    /// @param now  current time
+    /// @param send called with each frame
+    ///
+    /// @return std::chrono::milliseconds time after which the remaining
+    ///         frames can be sent, 0 if none remain
+    ///
+    template <class Send>
+    std::chrono::milliseconds flush(
+        std::chrono::steady_clock::time_point now, Send&& send) {
+        buildFrames();
+        if (now - windowStart >= WINDOW) {
+            windowStart = now;
+            framesInWindow = 0;
+        };
+        while (!frames.empty() && framesInWindow < maxFramesPerSecond) {
+            send(frames.front());
+            frames.pop_front();
+            framesInWindow++;
+        };
+        if (frames.empty()) { return std::chrono::milliseconds(0); };
+        return std::max(std::chrono::milliseconds(1),
+            std::chrono::ceil<std::chrono::milliseconds>(
+                windowStart + WINDOW - now));
+    };
+
+  private:
+    static constexpr std::chrono::seconds WINDOW { 1 };
+
+    size_t maxTokensPerFrame = DEFAULT_MAX_TOKENS_PER_FRAME;
+    unsigned int maxFramesPerSecond = DEFAULT_MAX_FRAMES_PER_SECOND;
+    std::unordered_set<int> subscribed;
+    std::unordered_set<int> unsubscribed;
+    std::unordered_map<int, string> modes;
+    std::deque<string> frames;
+    std::chrono::steady_clock::time_point windowStart;
+    unsigned int framesInWindow = 0;
+
+    // e.g., {"a":"subscribe","v":[408065,884737]} or, with a mode,
+    // {"a":"mode","v":["full",[408065,884737]]}
+    void addFrames(const char* action, const string& mode,
+        std::vector<int>& instrumentTokens) {
+        std::sort(instrumentTokens.begin(), instrumentTokens.end());
+        for (size_t first = 0; first < instrumentTokens.size();
+             first += maxTokensPerFrame) {
+            const size_t last =
+                std::min(first + maxTokensPerFrame, instrumentTokens.size());
+            string frame = R"({"a":")";
+            frame.append(action).append(R"(","v":)");
+            if (!mode.empty()) { frame.append(R"([")" + mode + R"(",)"); };
+            frame.push_back('[');
+            for (size_t idx = first; idx < last; idx++) {
+                if (idx != first) { frame.push_back(','); };
+                frame.append(std::to_string(instrumentTokens[idx]));
+            };
+            frame.push_back(']');
+            if (!mode.empty()) { frame.push_back(']'); };
+            frame.push_back('}');
+            frames.push_back(std::move(frame));
+        };
+    };
+
+    void buildFrames() {
+        std::vector<int> tokens(unsubscribed.begin(), unsubscribed.end());
+        addFrames("unsubscribe", "", tokens);
+        tokens.assign(subscribed.begin(), subscribed.end());
+        addFrames("subscribe", "", tokens);
+        std::map<string, std::vector<int>> byMode;
+        for (const auto& [token, mode] : modes) {
+            byMode[mode].push_back(token);
+        };
+        for (auto& [mode, modeTokens] : byMode) {
+            addFrames("mode", mode, modeTokens);
+        };
+        subscribed.clear();
+        unsubscribed.clear();
+        modes.clear();
+    };
+};
+
+} // namespace kiteconnect::internal
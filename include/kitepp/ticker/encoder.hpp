@@ -0,0 +1,377 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../span.hpp"
+#include "../userconstants.hpp" //modes
+#include "binary.hpp"
+#include "parser.hpp"
+
+namespace kiteconnect::internal::binary {
+
+namespace kc = kiteconnect;
+
+/// @brief Get the mode of a `kc::tick`.
+inline kc::TICK_MODE getMode(const kc::tick& Tick) {
+    if (Tick.mode == MODE_LTP) { return kc::TICK_MODE::LTP; };
+    if (Tick.mode == MODE_QUOTE) { return kc::TICK_MODE::QUOTE; };
+    return kc::TICK_MODE::FULL;
+};
+
+/// @brief Get the mode of a `kc::compactTick` or `kc::fixedTick`.
+template <class Tick>
+kc::TICK_MODE getMode(const Tick& tick) {
+    return tick.mode;
+};
+
+/// @brief Get the size of the packet \a tick is encoded into.
+template <class Tick>
+size_t packetSize(const Tick& tick) {
+    switch (getMode(tick)) {
+        case kc::TICK_MODE::LTP: return layout::ltp::SIZE;
+        case kc::TICK_MODE::QUOTE:
+            return tick.isTradable ? layout::quote::SIZE :
+                                     layout::indicesQuote::SIZE;
+        case kc::TICK_MODE::FULL:
+        default:
+            return tick.isTradable ? layout::full::SIZE :
+                                     layout::indicesFull::SIZE;
+    };
+};
+
+/// @brief Scale \a price of \a Tick back to the integer sent on the wire.
+template <class Tick, class Price>
+int32_t unscalePrice(Price price, double divisor) {
+    if constexpr (IS_FIXED_POINT<Tick>) {
+        return price;
+    } else {
+        return static_cast<int32_t>(std::llround(price * divisor));
+    };
+};
+
+/// @brief Encode the market depth of \a tick into a full packet.
+template <class Tick>
+void encodeDepth(const Tick& tick, double divisor, char* depth) {
+    using Layout = layout::full;
+    constexpr size_t entriesPerSide = Layout::DEPTH_ENTRIES / 2;
+    const auto& [buy, sell] = tick.marketDepth;
+    for (size_t i = 0; i < Layout::DEPTH_ENTRIES; i++) {
+        char* entry = depth + (i * Layout::DEPTH_ENTRY_SIZE);
+        const auto& side = (i < entriesPerSide) ? buy : sell;
+        const size_t idx = i % entriesPerSide;
+        if (idx >= side.size()) {
+            std::memset(entry, 0, Layout::DEPTH_ENTRY_SIZE);
+            continue;
+        };
+        pack<int32_t>(entry + Layout::DEPTH_QUANTITY, side[idx].quantity);
+        pack<int32_t>(entry + Layout::DEPTH_PRICE,
+            unscalePrice<Tick>(side[idx].price, divisor));
+        pack<int16_t>(entry + Layout::DEPTH_ORDERS, side[idx].orders);
+        pack<int16_t>(entry + Layout::DEPTH_ORDERS + sizeof(int16_t), 0);
+    };
+};
+
+///
+/// @brief Encode \a tick into a packet. The inverse of `parsePacket()`.
+///
+/// @tparam Tick `kc::tick`, `kc::compactTick` or `kc::fixedTick`
+///
+/// @param tick   tick to encode
+/// @param packet buffer of at least `packetSize(tick)` bytes
+///
+/// @return size_t size of the packet
+///
+template <class Tick>
+size_t encodePacket(const Tick& tick, char* packet) {
+    const double divisor = priceDivisor(tick.instrumentToken);
+    const auto price = [divisor](auto Price) {
+        return unscalePrice<Tick>(Price, divisor);
+    };
+    const size_t size = packetSize(tick);
+    pack<int32_t>(packet + layout::ltp::INSTRUMENT_TOKEN, tick.instrumentToken);
+    pack<int32_t>(packet + layout::ltp::LAST_PRICE, price(tick.lastPrice));
+
+    if (size == layout::indicesQuote::SIZE ||
+        size == layout::indicesFull::SIZE) {
+        using Layout = layout::indicesFull;
+        pack<int32_t>(packet + Layout::HIGH, price(tick.ohlc.high));
+        pack<int32_t>(packet + Layout::LOW, price(tick.ohlc.low));
+        pack<int32_t>(packet + Layout::OPEN, price(tick.ohlc.open));
+        pack<int32_t>(packet + Layout::CLOSE, price(tick.ohlc.close));
+        pack<int32_t>(packet + Layout::NET_CHANGE, price(tick.netChange));
+        if (size == Layout::SIZE) {
+            pack<int32_t>(packet + Layout::TIMESTAMP, tick.timestamp);
+        };
+    } else if (size == layout::quote::SIZE || size == layout::full::SIZE) {
+        using Layout = layout::full;
+        pack<int32_t>(
+            packet + Layout::LAST_TRADED_QUANTITY, tick.lastTradedQuantity);
+        pack<int32_t>(packet + Layout::AVERAGE_TRADE_PRICE,
+            price(tick.averageTradePrice));
+        pack<int32_t>(packet + Layout::VOLUME_TRADED, tick.volumeTraded);
+        pack<int32_t>(
+            packet + Layout::TOTAL_BUY_QUANTITY, tick.totalBuyQuantity);
+        pack<int32_t>(
+            packet + Layout::TOTAL_SELL_QUANTITY, tick.totalSellQuantity);
+        pack<int32_t>(packet + Layout::OPEN, price(tick.ohlc.open));
+        pack<int32_t>(packet + Layout::HIGH, price(tick.ohlc.high));
+        pack<int32_t>(packet + Layout::LOW, price(tick.ohlc.low));
+        pack<int32_t>(packet + Layout::CLOSE, price(tick.ohlc.close));
+        if (size == Layout::SIZE) {
+            pack<int32_t>(packet + Layout::LAST_TRADE_TIME, tick.lastTradeTime);
+            pack<int32_t>(packet + Layout::OI, tick.oi);
+            pack<int32_t>(packet + Layout::OI_DAY_HIGH, tick.oiDayHigh);
+            pack<int32_t>(packet + Layout::OI_DAY_LOW, tick.oiDayLow);
+            pack<int32_t>(packet + Layout::TIMESTAMP, tick.timestamp);
+            encodeDepth(tick, divisor, packet + Layout::DEPTH);
+        };
+    };
+    return size;
+};
+
+///
+/// @brief Encode \a ticks into a binary message, replacing the contents of
+///        \a frame. The inverse of `parse()`.
+///
+/// @tparam Tick `kc::tick`, `kc::compactTick` or `kc::fixedTick`
+///
+/// @param ticks ticks to encode
+/// @param frame encoded message
+///
+template <class Tick>
+void encode(kc::span<const Tick> ticks, std::vector<char>& frame) {
+    if (ticks.size() >
+        static_cast<size_t>(std::numeric_limits<int16_t>::max())) {
+        throw kc::libException("too many ticks for a single binary message");
+    };
+    size_t size = LENGTH_SIZE;
+    for (const Tick& tick : ticks) { size += LENGTH_SIZE + packetSize(tick); };
+    frame.resize(size);
+
+    char* out = frame.data();
+    pack<int16_t>(out, static_cast<int16_t>(ticks.size()));
+    out += LENGTH_SIZE;
+    for (const Tick& tick : ticks) {
+        const size_t packetLength = encodePacket(tick, out + LENGTH_SIZE);
+        pack<int16_t>(out, static_cast<int16_t>(packetLength));
+        out += LENGTH_SIZE + packetLength;
+    };
+};
+
+///
+/// @brief Encode \a ticks into a binary message.
+///
+/// @return std::vector<char> encoded message
+///
+template <class Tick>
+std::vector<char> encode(const std::vector<Tick>& ticks) {
+    std::vector<char> frame;
+    encode(kc::span<const Tick>(ticks), frame);
+    return frame;
+};
+
+///
+/// @brief Generates random, but internally consistent, binary messages for
+///        load and stress testing. Prices move around a per-instrument base
+///        price, OHLC brackets the last price and market depth is sorted.
+///
+/// Packets are written straight into a reused buffer using a xorshift
+/// generator, so generating a message doesn't allocate once the buffer is
+/// large enough.
+///
+class frameGenerator {
+
+  public:
+    ///
+    /// @brief Construct a new frame generator.
+    ///
+    /// @param Seed     messages generated with the same seed are the same
+    /// @param Segments segments instruments are picked from
+    /// @param Modes    modes packets are sent in
+    ///
+    explicit frameGenerator(uint64_t Seed = DEFAULT_SEED,
+        std::vector<SEGMENTS> Segments = { SEGMENTS::NSE, SEGMENTS::NFO,
+            SEGMENTS::CDS, SEGMENTS::BSE, SEGMENTS::BFO, SEGMENTS::BSECDS,
+            SEGMENTS::MCX, SEGMENTS::INDICES },
+        std::vector<kc::TICK_MODE> Modes = { kc::TICK_MODE::LTP,
+            kc::TICK_MODE::QUOTE, kc::TICK_MODE::FULL })
+        : state(Seed == 0 ? DEFAULT_SEED : Seed),
+          segments(std::move(Segments)), modes(std::move(Modes)) {
+        if (segments.empty() || modes.empty()) {
+            throw kc::libException("segments and modes can't be empty");
+        };
+    };
+
+    ///
+    /// @brief Generate a message of \a numberOfPackets packets.
+    ///
+    /// @return const std::vector<char>& message, valid until the next call
+    ///
+    const std::vector<char>& next(size_t numberOfPackets) {
+        if (numberOfPackets >
+            static_cast<size_t>(std::numeric_limits<int16_t>::max())) {
+            throw kc::libException("too many packets for a single message");
+        };
+        frame.resize(LENGTH_SIZE + (numberOfPackets *
+                                       (LENGTH_SIZE + layout::full::SIZE)));
+        char* out = frame.data();
+        pack<int16_t>(out, static_cast<int16_t>(numberOfPackets));
+        out += LENGTH_SIZE;
+        for (size_t i = 0; i < numberOfPackets; i++) {
+            const size_t packetLength = writePacket(out + LENGTH_SIZE);
+            pack<int16_t>(out, static_cast<int16_t>(packetLength));
+            out += LENGTH_SIZE + packetLength;
+        };
+        frame.resize(static_cast<size_t>(out - frame.data()));
+        return frame;
+    };
+
+  private:
+    static constexpr uint64_t DEFAULT_SEED = 0x9e3779b97f4a7c15ULL;
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+    static constexpr int32_t MAX_INSTRUMENT_ID = 0xffffff;
+    static constexpr int32_t MIN_BASE_PRICE = 1000;
+    static constexpr int32_t MAX_BASE_PRICE = 10000000;
+    static constexpr int64_t PRICE_STEP = 7919;
+    static constexpr int32_t MAX_QUANTITY = 100000;
+    static constexpr int16_t MAX_ORDERS = 100;
+    static constexpr int32_t START_TIMESTAMP = 1612777255;
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+    uint64_t state;
+    const std::vector<SEGMENTS> segments;
+    const std::vector<kc::TICK_MODE> modes;
+    std::vector<char> frame;
+    int32_t timestamp = START_TIMESTAMP;
+
+    uint64_t random() {
+        // xorshift64*
+        // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+        state ^= state >> 12U;
+        state ^= state << 25U;
+        state ^= state >> 27U;
+        return state * 0x2545f4914f6cdd1dULL;
+        // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+    };
+
+    /// @brief Get a random integer in [min, max].
+    int32_t random(int32_t min, int32_t max) {
+        const auto range = static_cast<uint64_t>(max - min) + 1;
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        return min + static_cast<int32_t>((random() >> 32U) % range);
+    };
+
+    size_t writePacket(char* packet) {
+        const SEGMENTS segment = segments[random() % segments.size()];
+        const kc::TICK_MODE mode = modes[random() % modes.size()];
+        const bool isIndex = segment == SEGMENTS::INDICES;
+        const int32_t id = random(1, MAX_INSTRUMENT_ID);
+        // NOLINTNEXTLINE(hicpp-signed-bitwise)
+        const int32_t instrumentToken = (id << 8) | static_cast<int>(segment);
+        // stable per instrument so prices look like they belong together
+        const auto basePrice = static_cast<int32_t>(MIN_BASE_PRICE +
+            (int64_t { id } * PRICE_STEP) % (MAX_BASE_PRICE - MIN_BASE_PRICE));
+        const int32_t spread = std::max(basePrice / 1000, 1);
+        const int32_t close = basePrice;
+        const int32_t lastPrice = close + random(-50 * spread, 50 * spread);
+        const int32_t low = std::min(lastPrice, close) - random(0, spread);
+        const int32_t high = std::max(lastPrice, close) + random(0, spread);
+        const int32_t open = random(low, high);
+        timestamp += static_cast<int32_t>(random() & 1U);
+
+        pack<int32_t>(packet + layout::ltp::INSTRUMENT_TOKEN, instrumentToken);
+        pack<int32_t>(packet + layout::ltp::LAST_PRICE, lastPrice);
+        if (mode == kc::TICK_MODE::LTP) { return layout::ltp::SIZE; };
+
+        if (isIndex) {
+            using Layout = layout::indicesFull;
+            pack<int32_t>(packet + Layout::HIGH, high);
+            pack<int32_t>(packet + Layout::LOW, low);
+            pack<int32_t>(packet + Layout::OPEN, open);
+            pack<int32_t>(packet + Layout::CLOSE, close);
+            pack<int32_t>(packet + Layout::NET_CHANGE, lastPrice - close);
+            if (mode == kc::TICK_MODE::QUOTE) {
+                return layout::indicesQuote::SIZE;
+            };
+            pack<int32_t>(packet + Layout::TIMESTAMP, timestamp);
+            return Layout::SIZE;
+        };
+
+        using Layout = layout::full;
+        const int32_t volume = random(0, MAX_QUANTITY) * 100;
+        pack<int32_t>(
+            packet + Layout::LAST_TRADED_QUANTITY, random(1, MAX_QUANTITY));
+        pack<int32_t>(packet + Layout::AVERAGE_TRADE_PRICE, random(low, high));
+        pack<int32_t>(packet + Layout::VOLUME_TRADED, volume);
+        pack<int32_t>(packet + Layout::TOTAL_BUY_QUANTITY, random(0, volume));
+        pack<int32_t>(packet + Layout::TOTAL_SELL_QUANTITY, random(0, volume));
+        pack<int32_t>(packet + Layout::OPEN, open);
+        pack<int32_t>(packet + Layout::HIGH, high);
+        pack<int32_t>(packet + Layout::LOW, low);
+        pack<int32_t>(packet + Layout::CLOSE, close);
+        if (mode == kc::TICK_MODE::QUOTE) { return layout::quote::SIZE; };
+
+        const int32_t oi = random(0, MAX_QUANTITY);
+        pack<int32_t>(packet + Layout::LAST_TRADE_TIME, timestamp);
+        pack<int32_t>(packet + Layout::OI, oi);
+        pack<int32_t>(packet + Layout::OI_DAY_HIGH, oi + random(0, oi));
+        pack<int32_t>(packet + Layout::OI_DAY_LOW, oi - random(0, oi));
+        pack<int32_t>(packet + Layout::TIMESTAMP, timestamp);
+        constexpr size_t entriesPerSide = Layout::DEPTH_ENTRIES / 2;
+        int32_t bid = lastPrice;
+        int32_t ask = lastPrice;
+        for (size_t i = 0; i < entriesPerSide; i++) {
+            bid -= random(1, spread);
+            ask += random(1, spread);
+            writeDepthEntry(packet + Layout::DEPTH, i, bid);
+            writeDepthEntry(packet + Layout::DEPTH, entriesPerSide + i, ask);
+        };
+        return Layout::SIZE;
+    };
+
+    void writeDepthEntry(char* depth, size_t idx, int32_t price) {
+        using Layout = layout::full;
+        char* entry = depth + (idx * Layout::DEPTH_ENTRY_SIZE);
+        pack<int32_t>(entry + Layout::DEPTH_QUANTITY, random(1, MAX_QUANTITY));
+        pack<int32_t>(entry + Layout::DEPTH_PRICE, price);
+        pack<int16_t>(entry + Layout::DEPTH_ORDERS,
+            static_cast<int16_t>(random(1, MAX_ORDERS)));
+        pack<int16_t>(entry + Layout::DEPTH_ORDERS + sizeof(int16_t), 0);
+    };
+};
+
+} // namespace kiteconnect::internal::binary
@@ -25,15 +25,17 @@
 
 #pragma once
 
-#include <algorithm> //reverse
 #include <atomic>
 #include <chrono>
 #include <cstdint>
-#include <cstring> //memcpy
 #include <functional>
+#include <future>
 #include <ios>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -44,6 +46,7 @@
 #include "../responses/responses.hpp"
 #include "../userconstants.hpp" //modes
 #include "../utils.hpp"
+#include "parser.hpp"
 #include "ws.hpp"
 
 #include "rapidjson/include/rapidjson/document.h"
@@ -59,6 +62,7 @@ using std::string;
 namespace rj = rapidjson;
 namespace kc = kiteconnect;
 namespace utils = kc::internal::utils;
+namespace binary = kc::internal::binary;
 
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
 inline ticker::ticker(string Key, unsigned int ConnectTimeout,
@@ -70,6 +74,11 @@ inline ticker::ticker(string Key, unsigned int ConnectTimeout,
       maxReconnectTries(MaxReconnectTries),
       group(hub.createGroup<uWS::CLIENT>()) {};
 
+inline ticker::~ticker() {
+    if (ioThread.joinable()) { stop(); };
+    if (ordersFetcher.joinable()) { ordersFetcher.join(); };
+};
+
 inline void ticker::setApiKey(const string& Key) { key = Key; };
 
 inline string ticker::getApiKey() const { return key; };
@@ -92,78 +101,392 @@ inline std::chrono::time_point<std::chrono::system_clock> ticker::
 
 inline void ticker::run() { hub.run(); };
 
+inline int ticker::getPollFd() {
+// backend picked as uWS's Backend.h does
+#if defined(USE_ASIO)
+    throw kc::libException("polling isn't supported by this uWS backend");
+#elif !defined(__linux__) || defined(USE_LIBUV)
+    return uv_backend_fd(hub.getLoop());
+#else
+    return hub.getLoop()->getEpollFd();
+#endif
+};
+
+inline int ticker::getPollTimeout() {
+#if defined(USE_ASIO)
+    throw kc::libException("polling isn't supported by this uWS backend");
+#elif !defined(__linux__) || defined(USE_LIBUV)
+    return uv_backend_timeout(hub.getLoop());
+#else
+    return hub.getLoop()->delay;
+#endif
+};
+
+inline void ticker::poll() {
+    if (ioThread.joinable()) {
+        throw kc::libException("I/O thread is running");
+    };
+    hub.poll();
+};
+
 inline void ticker::stop() {
-    if (isConnected()) { ws->close(); };
+    if (ioThread.joinable() &&
+        ioThread.get_id() != std::this_thread::get_id()) {
+        // the loop isn't thread safe, have the I/O thread stop it instead
+        if (uS::Async* async = stopAsync.exchange(nullptr)) { async->send(); };
+        ioThread.join();
+    } else {
+        stopInternal();
+    };
+    if (ordersFetcher.joinable()) { ordersFetcher.join(); };
+    if (shards) { shards->stop(); };
+    if (multicast) { multicast->close(); };
 };
 
-inline void ticker::subscribe(const std::vector<int>& instrumentTokens) {
-    utils::json::json<utils::json::JsonObject> req;
-    req.field("a", "subscribe");
-    req.field("v", instrumentTokens);
-    string reqStr = req.serialize();
-
-    if (isConnected()) {
-        ws->send(reqStr.data(), reqStr.size(), uWS::OpCode::TEXT);
-        for (const int tok : instrumentTokens) {
-            subbedInstruments[tok] = DEFAULT_MODE;
+inline void ticker::startIoThread(size_t queueCapacity) {
+    if (ioThread.joinable()) {
+        throw kc::libException("I/O thread is already running");
+    };
+    if (queueCapacity > 0) {
+        tickQueue =
+            std::make_unique<kc::spscRing<kc::compactTick>>(queueCapacity);
+    };
+
+    // freed by the loop once closed
+    auto* async = new uS::Async(hub.getLoop());
+    async->setData(this);
+    async->start([](uS::Async* Async) {
+        auto* Ticker = static_cast<ticker*>(Async->getData());
+        Ticker->runTasks();
+        {
+            const std::lock_guard<std::mutex> lock(Ticker->tasksMutex);
+            Ticker->tasksAsync->close();
+            Ticker->tasksAsync = nullptr;
         };
-    } else {
-        throw kc::libException("not connected to websocket server");
+        Ticker->stopInternal();
+        // stops auto ping, letting the loop exit
+        Ticker->group->close();
+        Async->close();
+    });
+    stopAsync = async;
+
+    tasksAsync = new uS::Async(hub.getLoop());
+    tasksAsync->setData(this);
+    tasksAsync->start([](uS::Async* Async) {
+        static_cast<ticker*>(Async->getData())->runTasks();
+    });
+    ioThread = std::thread([this]() {
+        hub.run();
+        // the loop can also exit on its own; fail what it didn't get to
+        {
+            const std::lock_guard<std::mutex> lock(tasksMutex);
+            tasksAsync = nullptr;
+        };
+        runTasks();
+    });
+};
+
+inline void ticker::post(std::function<void(ticker* ws)> task) {
+    {
+        const std::lock_guard<std::mutex> lock(tasksMutex);
+        if (tasksAsync != nullptr) {
+            tasks.push_back(std::move(task));
+            tasksAsync->send();
+            return;
+        };
+    };
+    if (isOffIoThread()) { throw kc::libException("I/O thread is stopping"); };
+    task(this);
+};
+
+inline bool ticker::isOffIoThread() const {
+    return ioThread.joinable() &&
+           ioThread.get_id() != std::this_thread::get_id();
+};
+
+inline std::future<void> ticker::postCommand(
+    std::function<void(ticker* ws)> command) {
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> future = done->get_future();
+    post([command = std::move(command), done](ticker* ws) {
+        try {
+            command(ws);
+            done->set_value();
+        } catch (...) { done->set_exception(std::current_exception()); };
+    });
+    return future;
+};
+
+inline void ticker::runTasks() {
+    std::vector<std::function<void(ticker* ws)>> pending;
+    {
+        const std::lock_guard<std::mutex> lock(tasksMutex);
+        pending.swap(tasks);
     };
+    for (auto& task : pending) { task(this); };
+};
+
+inline kc::spscRing<kc::compactTick>& ticker::getTickQueue() {
+    if (!tickQueue) { throw kc::libException("I/O thread was never started"); };
+    return *tickQueue;
+};
+
+inline kc::queueStats ticker::getTickQueueStats() const {
+    return tickQueue ? tickQueue->stats() : kc::queueStats();
+};
+
+inline void ticker::startShardWorkers(size_t NumberOfWorkers,
+    kc::tickShards::callback onShardTicks, size_t queueCapacity,
+    const std::vector<int>& cpus) {
+    if (shards) {
+        throw kc::libException("shard workers are already running");
+    };
+    shards = std::make_unique<kc::tickShards>(
+        NumberOfWorkers, std::move(onShardTicks), queueCapacity, cpus);
+};
+
+inline kc::queueStats ticker::getShardStats(size_t shard) const {
+    if (!shards) {
+        throw kc::libException("shard workers were never started");
+    };
+    return shards->getStats(shard);
+};
+
+inline void ticker::subscribe(const std::vector<int>& instrumentTokens) {
+    subscribe(DEFAULT_SUBSCRIBER, instrumentTokens, MODE_QUOTE);
 };
 
 inline void ticker::unsubscribe(const std::vector<int>& instrumentTokens) {
-    utils::json::json<utils::json::JsonObject> req;
-    req.field("a", "unsubscribe");
-    req.field("v", instrumentTokens);
-    string reqStr = req.serialize();
-
-    if (isConnected()) {
-        ws->send(reqStr.data(), reqStr.size(), uWS::OpCode::TEXT);
-        for (const int tok : instrumentTokens) {
-            auto it = subbedInstruments.find(tok);
-            if (it != subbedInstruments.end()) { subbedInstruments.erase(it); };
-        };
-    } else {
+    unsubscribe(DEFAULT_SUBSCRIBER, instrumentTokens);
+};
+
+inline void ticker::setMode(
+    const string& mode, const std::vector<int>& instrumentTokens) {
+    subscribe(DEFAULT_SUBSCRIBER, instrumentTokens, mode);
+};
+
+inline uint32_t ticker::addSubscriber() { return ++lastSubscriber; };
+
+inline void ticker::subscribe(uint32_t subscriber,
+    const std::vector<int>& instrumentTokens, const string& mode) {
+    if (isOffIoThread()) {
+        postCommand([subscriber, instrumentTokens, mode](ticker* ws) {
+            ws->subscribe(subscriber, instrumentTokens, mode);
+        }).get();
+        return;
+    };
+    if (!isConnected()) {
         throw kc::libException("not connected to websocket server");
     };
+    sendChanges(subbedInstruments.request(
+        subscriber, instrumentTokens, internal::toTickMode(mode)));
 };
 
-inline void ticker::setMode(
+inline void ticker::unsubscribe(
+    uint32_t subscriber, const std::vector<int>& instrumentTokens) {
+    if (isOffIoThread()) {
+        postCommand([subscriber, instrumentTokens](ticker* ws) {
+            ws->unsubscribe(subscriber, instrumentTokens);
+        }).get();
+        return;
+    };
+    if (!isConnected()) {
+        throw kc::libException("not connected to websocket server");
+    };
+    sendChanges(subbedInstruments.release(subscriber, instrumentTokens));
+};
+
+inline void ticker::removeSubscriber(uint32_t subscriber) {
+    if (isOffIoThread()) {
+        postCommand([subscriber](ticker* ws) {
+            ws->removeSubscriber(subscriber);
+        }).get();
+        return;
+    };
+    // dropped even if disconnected, nothing is resubscribed for it then
+    sendChanges(subbedInstruments.releaseAll(subscriber));
+};
+
+inline void ticker::sendChanges(const internal::subscriptionChanges& changes) {
+    if (changes.empty() || !isConnected()) { return; };
+    control.unsubscribe(changes.unsubscribed);
+    control.subscribe(changes.subscribed);
+    for (size_t mode = 0; mode < changes.modes.size(); mode++) {
+        if (changes.modes[mode].empty()) { continue; };
+        control.setMode(
+            internal::modeName(static_cast<kc::TICK_MODE>(mode)),
+            changes.modes[mode]);
+    };
+    scheduleControl(std::chrono::milliseconds(0));
+};
+
+inline void ticker::setControlFrameLimits(
+    size_t maxTokensPerFrame, unsigned int maxFramesPerSecond) {
+    control.setLimits(maxTokensPerFrame, maxFramesPerSecond);
+};
+
+inline void ticker::scheduleControl(std::chrono::milliseconds delay) {
+    // changes made until the timer fires go out with the same frames
+    if (controlTimer != nullptr) { return; };
+    controlTimer = new uS::Timer(hub.getLoop());
+    controlTimer->setData(this);
+    controlTimer->start(
+        [](uS::Timer* Timer) {
+            auto* Ticker = static_cast<ticker*>(Timer->getData());
+            Ticker->cancelControl();
+            Ticker->flushControl();
+        },
+        static_cast<int>(delay.count()), 0);
+};
+
+inline void ticker::cancelControl() {
+    if (controlTimer == nullptr) { return; };
+    controlTimer->stop();
+    controlTimer->close();
+    controlTimer = nullptr;
+};
+
+inline void ticker::flushControl() {
+    if (!isConnected()) {
+        // resubscribed from `subbedInstruments` once reconnected
+        control.clear();
+        return;
+    };
+    const std::chrono::milliseconds delay = control.flush(
+        std::chrono::steady_clock::now(), [this](const string& frame) {
+            ws->send(frame.data(), frame.size(), uWS::OpCode::TEXT);
+        });
+    if (delay.count() > 0) { scheduleControl(delay); };
+};
+
+inline std::future<void> ticker::subscribeAsync(
+    const std::vector<int>& instrumentTokens) {
+    return postCommand(
+        [instrumentTokens](ticker* ws) { ws->subscribe(instrumentTokens); });
+};
+
+inline std::future<void> ticker::unsubscribeAsync(
+    const std::vector<int>& instrumentTokens) {
+    return postCommand(
+        [instrumentTokens](ticker* ws) { ws->unsubscribe(instrumentTokens); });
+};
+
+inline std::future<void> ticker::setModeAsync(
     const string& mode, const std::vector<int>& instrumentTokens) {
-    // create request json
-    rj::Document req;
-    req.SetObject();
-    auto& reqAlloc = req.GetAllocator();
-    rj::Value val;
-    rj::Value valArr(rj::kArrayType);
-    rj::Value toksArr(rj::kArrayType);
-
-    val.SetString("mode", reqAlloc);
-    req.AddMember("a", val, reqAlloc);
-
-    val.SetString(mode.c_str(), mode.size(), reqAlloc);
-    valArr.PushBack(val, reqAlloc);
-    for (const int tok : instrumentTokens) { toksArr.PushBack(tok, reqAlloc); }
-    valArr.PushBack(toksArr, reqAlloc);
-    req.AddMember("v", valArr, reqAlloc);
-
-    // send the request
-    string reqStr = utils::json::serialize(req);
-    if (isConnected()) {
-        ws->send(reqStr.data(), reqStr.size(), uWS::OpCode::TEXT);
-        for (const int tok : instrumentTokens) {
-            if (mode == MODE_LTP) {
-                subbedInstruments[tok] = MODES::LTP;
-            } else if (mode == MODE_QUOTE) {
-                subbedInstruments[tok] = MODES::QUOTE;
-            } else {
-                subbedInstruments[tok] = MODES::FULL;
-            }
+    return postCommand([mode, instrumentTokens](ticker* ws) {
+        ws->setMode(mode, instrumentTokens);
+    });
+};
+
+inline void ticker::setFieldMask(uint32_t fields) {
+    fieldMasks.defaultFields = fields;
+};
+
+inline void ticker::setFieldMask(
+    uint32_t fields, const std::vector<int>& instrumentTokens) {
+    for (const int tok : instrumentTokens) { fieldMasks.set(tok, fields); };
+};
+
+inline void ticker::enableLastValueCache(size_t maxInstruments) {
+    if (lastValues) {
+        throw kc::libException("last value cache is already enabled");
+    };
+    lastValues = std::make_unique<kc::lastValueCache>(maxInstruments);
+};
+
+inline const kc::lastValueCache& ticker::getLastValueCache() const {
+    if (!lastValues) {
+        throw kc::libException("last value cache isn't enabled");
+    };
+    return *lastValues;
+};
+
+inline kc::multicastRing& ticker::enableMulticast(
+    size_t capacity, kc::WAIT_STRATEGY strategy) {
+    if (multicast) { throw kc::libException("multicast is already enabled"); };
+    multicast = std::make_unique<kc::multicastRing>(capacity, strategy);
+    return *multicast;
+};
+
+inline void ticker::enableSharedMemoryBus(const string& name, size_t capacity) {
+    if (shmBus) {
+        throw kc::libException("shared memory bus is already enabled");
+    };
+    shmBus = std::make_unique<kc::shmPublisher>(name, capacity);
+};
+
+inline void ticker::enableOrderBook(size_t maxOrders,
+    std::function<std::vector<kc::order>()> FetchOrders) {
+    if (orderStates) {
+        throw kc::libException("order book is already enabled");
+    };
+    orderStates = std::make_unique<kc::orderBook>(maxOrders);
+    fetchOrders = std::move(FetchOrders);
+};
+
+inline const kc::orderBook& ticker::getOrderBook() const {
+    if (!orderStates) { throw kc::libException("order book isn't enabled"); };
+    return *orderStates;
+};
+
+inline void ticker::loadOrders() {
+    if (isFetchingOrders.exchange(true)) { return; };
+    // the previous fetch handed over its result & is exiting
+    if (ordersFetcher.joinable()) { ordersFetcher.join(); };
+    // fetching blocks, so it's done on a thread of its own & the result is
+    // handed back to the loop, which is the order book's only writer
+    ordersFetcher = std::thread([this, fetch = fetchOrders]() {
+        std::function<void(ticker* ws)> result;
+        try {
+            result = [orders = fetch()](ticker* ws) {
+                ws->orderStates->load(orders);
+                ws->fetchOrders = nullptr;
+            };
+        } catch (kc::kiteppException& ex) {
+            result = [code = ex.code(), message = string(ex.what())](
+                         ticker* ws) {
+                if (ws->onError) { ws->onError(ws, code, message); };
+            };
+        } catch (std::exception& ex) {
+            result = [message = string(ex.what())](ticker* ws) {
+                if (ws->onError) { ws->onError(ws, 0, message); };
+            };
         };
-    } else {
-        throw kc::libException("not connected to websocket server");
+        {
+            const std::lock_guard<std::mutex> lock(fetchedMutex);
+            fetchedOrders = std::move(result);
+        };
+        hasFetchedOrders.store(true, std::memory_order_release);
+        // wake the I/O thread. Loops run by the user pick the result up with
+        // the next message, e.g., a heartbeat.
+        const std::lock_guard<std::mutex> lock(tasksMutex);
+        if (tasksAsync != nullptr) {
+            tasks.emplace_back(
+                [](ticker* ws) { ws->applyFetchedOrders(); });
+            tasksAsync->send();
+        };
+    });
+};
+
+inline void ticker::applyFetchedOrders() {
+    if (!hasFetchedOrders.exchange(false, std::memory_order_acquire)) {
+        return;
+    };
+    std::function<void(ticker* ws)> result;
+    {
+        const std::lock_guard<std::mutex> lock(fetchedMutex);
+        result.swap(fetchedOrders);
     };
+    isFetchingOrders.store(false, std::memory_order_relaxed);
+    if (result) { result(this); };
+};
+
+inline void ticker::stopInternal() {
+    // pending timers would keep the loop running
+    cancelReconnect();
+    cancelControl();
+    isReconnecting = false;
+    if (isConnected()) { ws->close(); };
 };
 
 inline void ticker::connectInternal() {
@@ -172,201 +495,122 @@ inline void ticker::connectInternal() {
 };
 
 inline void ticker::reconnect() {
-    if (isConnected()) { return; };
+    if (isConnected() || reconnectTimer != nullptr) { return; };
+    if (!isReconnecting) { disconnectTime = std::chrono::steady_clock::now(); };
     isReconnecting = true;
     reconnectTries++;
 
     if (reconnectTries <= maxReconnectTries) {
-        std::this_thread::sleep_for(std::chrono::seconds(reconnectDelay));
-        reconnectDelay = (reconnectDelay * 2 > maxReconnectDelay) ?
-                             maxReconnectDelay :
-                             reconnectDelay * 2;
-
-        if (onTryReconnect) { onTryReconnect(this, reconnectTries); };
-        connectInternal();
+        const std::chrono::milliseconds delay = utils::ws::reconnectDelay(
+            reconnectTries, std::chrono::seconds(initReconnectDelay),
+            std::chrono::seconds(maxReconnectDelay),
+            std::uniform_real_distribution<double>(0, 1)(reconnectJitter));
+        if (onReconnectScheduled) {
+            onReconnectScheduled(this, reconnectTries, delay);
+        };
 
-        if (isConnected()) { return; };
+        // waiting on the loop lets it serve other groups & timers meanwhile
+        reconnectTimer = new uS::Timer(hub.getLoop());
+        reconnectTimer->setData(this);
+        reconnectTimer->start(
+            [](uS::Timer* Timer) {
+                auto* Ticker = static_cast<ticker*>(Timer->getData());
+                Ticker->cancelReconnect();
+                if (Ticker->onTryReconnect) {
+                    Ticker->onTryReconnect(Ticker, Ticker->reconnectTries);
+                };
+                Ticker->connectInternal();
+            },
+            static_cast<int>(delay.count()), 0);
     } else {
         if (onReconnectFail) { onReconnectFail(this); };
         isReconnecting = false;
     };
 };
 
-inline void ticker::processTextMessage(const string& message) {
-    rj::Document res;
-    utils::json::parse(res, message);
-    if (!res.IsObject()) { throw libException("Expected a JSON object"); };
+inline void ticker::cancelReconnect() {
+    if (reconnectTimer == nullptr) { return; };
+    reconnectTimer->stop();
+    reconnectTimer->close();
+    reconnectTimer = nullptr;
+};
 
-    auto type = utils::json::get<string>(res, "type");
+inline void ticker::processTextMessage(const char* message, size_t length) {
+    textMessages.parse(message, length);
+
+    const string& type = textMessages.getType();
     if (type.empty()) {
         throw kc::libException(
             FMT("Cannot recognize websocket message type {0}", type));
     }
 
-    if (type == "order" && onOrderUpdate) {
-        onOrderUpdate(this, kc::postback(utils::json::extractObject(res)));
+    if (type == "order") {
+        if (orderStates) { orderStates->update(textMessages.getPostback()); };
+        if (onOrderUpdate) { onOrderUpdate(this, textMessages.getPostback()); };
     }
-    if (type == "message" && onMessage) { onMessage(this, message); };
+    if (type == "message" && onMessage) {
+        onMessage(this, string(message, length));
+    };
     if (type == "error" && onError) {
-        onError(this, 0, utils::json::extractString(res));
+        onError(this, 0, textMessages.getData());
     };
 };
 
-template <typename T>
-T ticker::unpack(const std::vector<char>& bytes, size_t start, size_t end) {
-    // FIXME directly iterate over bytes instead of making a copy or reversing
-    T value;
-    std::vector<char> requiredBytes(bytes.begin() + static_cast<int64_t>(start),
-        bytes.begin() + static_cast<int64_t>(end) + 1);
-
-    // clang-format off
-        #ifndef WORDS_BIGENDIAN
-        std::reverse(requiredBytes.begin(), requiredBytes.end());
-        #endif
-    // clang-format on
-
-    std::memcpy(&value, requiredBytes.data(), sizeof(T));
-    return value;
-};
-
-inline std::vector<std::vector<char>> ticker::splitPackets(
-    const std::vector<char>& bytes) {
-    const auto numberOfPackets = unpack<int16_t>(bytes, 0, 1);
-    std::vector<std::vector<char>> packets;
-
-    unsigned int packetLengthStartIdx = 2;
-    for (int i = 1; i <= numberOfPackets; i++) {
-        unsigned int packetLengthEndIdx = packetLengthStartIdx + 1;
-        auto packetLength =
-            unpack<int16_t>(bytes, packetLengthStartIdx, packetLengthEndIdx);
-        packetLengthStartIdx = packetLengthEndIdx + packetLength + 1;
-        packets.emplace_back(bytes.begin() + packetLengthEndIdx + 1,
-            bytes.begin() + packetLengthStartIdx);
-    };
-    return packets;
+inline std::vector<kc::tick> ticker::parseBinaryMessage(
+    const char* bytes, size_t size) {
+    return binary::parse(bytes, size);
 };
 
-inline std::vector<kc::tick> ticker::parseBinaryMessage(
-    char* bytes, size_t size) {
-    static constexpr uint8_t SEGMENT_MASK = 0xff;
-    static constexpr double CDS_DIVISOR = 10000000.0;
-    static constexpr double BSECDS_DIVISOR = 10000.0;
-    static constexpr double GENERIC_DIVISOR = 100.0;
-    static constexpr size_t LTP_PACKET_SIZE = 8;
-    static constexpr size_t INDICES_QUOTE_PACKET_SIZE = 28;
-    static constexpr size_t INDICES_FULL_PACKET_SIZE = 32;
-    static constexpr size_t QUOTE_PACKET_SIZE = 44;
-    static constexpr size_t FULL_PACKET_SIZE = 184;
-
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    std::vector<std::vector<char>> packets =
-        splitPackets(std::vector<char>(bytes, bytes + size));
-    if (packets.empty()) { return {}; };
-
-    std::vector<kc::tick> ticks;
-    for (const auto& packet : packets) {
-        const size_t packetSize = packet.size();
-        const auto instrumentToken = unpack<int32_t>(packet, 0, 3);
-        // NOLINTNEXTLINE(hicpp-signed-bitwise)
-        const uint8_t segment = instrumentToken & SEGMENT_MASK;
-        const bool tradable =
-            segment != static_cast<uint8_t>(SEGMENTS::INDICES);
-        double divisor = 0.0;
-        if (segment == static_cast<uint8_t>(SEGMENTS::CDS)) {
-            divisor = CDS_DIVISOR;
-
-        } else if (segment == static_cast<uint8_t>(SEGMENTS::BSECDS)) {
-            divisor = BSECDS_DIVISOR;
-
-        } else {
-            divisor = GENERIC_DIVISOR;
-        }
-
-        kc::tick Tick;
-        Tick.isTradable = tradable;
-        Tick.instrumentToken = instrumentToken;
-
-        // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
-        // LTP packet
-        if (packetSize == LTP_PACKET_SIZE) {
-            Tick.mode = MODE_LTP;
-            Tick.lastPrice = unpack<int32_t>(packet, 4, 7) / divisor;
-        } else if (packetSize == INDICES_QUOTE_PACKET_SIZE ||
-                   packetSize == INDICES_FULL_PACKET_SIZE) {
-            // indices quote and full mode
-            Tick.mode = (packetSize == INDICES_QUOTE_PACKET_SIZE) ? MODE_QUOTE :
-                                                                    MODE_FULL;
-            Tick.lastPrice = unpack<int32_t>(packet, 4, 7) / divisor;
-            Tick.ohlc.high = unpack<int32_t>(packet, 8, 11) / divisor;
-            Tick.ohlc.low = unpack<int32_t>(packet, 12, 15) / divisor;
-            Tick.ohlc.open = unpack<int32_t>(packet, 16, 19) / divisor;
-            Tick.ohlc.close = unpack<int32_t>(packet, 20, 23) / divisor;
-            Tick.netChange = unpack<int32_t>(packet, 24, 27) / divisor;
-            if (packetSize == INDICES_FULL_PACKET_SIZE) {
-                Tick.timestamp = unpack<int32_t>(packet, 28, 31);
-            }
-        } else if (packetSize == QUOTE_PACKET_SIZE ||
-                   packetSize == FULL_PACKET_SIZE) {
-            // Quote and full mode
-            Tick.mode =
-                (packetSize == QUOTE_PACKET_SIZE) ? MODE_QUOTE : MODE_FULL;
-            Tick.lastPrice = unpack<int32_t>(packet, 4, 7) / divisor;
-            Tick.lastTradedQuantity = unpack<int32_t>(packet, 8, 11);
-            Tick.averageTradePrice = unpack<int32_t>(packet, 12, 15) / divisor;
-            Tick.volumeTraded = unpack<int32_t>(packet, 16, 19);
-            Tick.totalBuyQuantity = unpack<int32_t>(packet, 20, 23);
-            Tick.totalSellQuantity = unpack<int32_t>(packet, 24, 27);
-            Tick.ohlc.open = unpack<int32_t>(packet, 28, 31) / divisor;
-            Tick.ohlc.high = unpack<int32_t>(packet, 32, 35) / divisor;
-            Tick.ohlc.low = unpack<int32_t>(packet, 36, 39) / divisor;
-            Tick.ohlc.close = unpack<int32_t>(packet, 40, 43) / divisor;
-            Tick.netChange =
-                (Tick.lastPrice - Tick.ohlc.close) * 100 / Tick.ohlc.close;
-
-            // parse full mode
-            if (packetSize == FULL_PACKET_SIZE) {
-                Tick.lastTradeTime = unpack<int32_t>(packet, 44, 47);
-                Tick.oi = unpack<int32_t>(packet, 48, 51);
-                Tick.oiDayHigh = unpack<int32_t>(packet, 52, 55);
-                Tick.oiDayLow = unpack<int32_t>(packet, 56, 59);
-                Tick.timestamp = unpack<int32_t>(packet, 60, 63);
-
-                unsigned int depthStartIdx = 64;
-                for (int i = 0; i <= 9; i++) {
-                    kc::depthWS depth;
-                    depth.quantity = unpack<int32_t>(
-                        packet, depthStartIdx, depthStartIdx + 3);
-                    depth.price = unpack<int32_t>(packet, depthStartIdx + 4,
-                                      depthStartIdx + 7) /
-                                  divisor;
-                    depth.orders = unpack<int16_t>(
-                        packet, depthStartIdx + 8, depthStartIdx + 9);
-
-                    (i >= 5) ? Tick.marketDepth.sell.emplace_back(depth) :
-                               Tick.marketDepth.buy.emplace_back(depth);
-                    depthStartIdx = depthStartIdx + 12;
-                };
-            };
+inline void ticker::processBinaryMessage(const char* bytes, size_t size) {
+    if (onTicks || onTicksView) {
+        const size_t parsed =
+            binary::parseInto(bytes, size, ticks, fieldMasks);
+        const kc::span<const kc::tick> view(ticks, parsed);
+        if (onTicksView) { onTicksView(this, view); };
+        if (onTicks) { onTicks(this, { view.begin(), view.end() }); };
+    };
+    if (onCompactTicks || tickQueue || shards || lastValues || multicast ||
+        shmBus) {
+        binary::parse(bytes, size, compactTicks, fieldMasks);
+        if (lastValues) {
+            lastValues->update(kc::span<const kc::compactTick>(compactTicks));
+        };
+        if (tickQueue) {
+            tickQueue->tryPush(kc::span<const kc::compactTick>(compactTicks));
         };
-        // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
-        ticks.emplace_back(Tick);
+        if (shards) {
+            shards->dispatch(kc::span<const kc::compactTick>(compactTicks));
+        };
+        if (multicast) {
+            multicast->publish(kc::span<const kc::compactTick>(compactTicks));
+        };
+        if (shmBus) {
+            shmBus->publish(kc::span<const kc::compactTick>(compactTicks));
+        };
+        if (onCompactTicks) { onCompactTicks(this, compactTicks); };
+    };
+    if (onFixedTicks) {
+        binary::parse(bytes, size, fixedTicks, fieldMasks);
+        onFixedTicks(this, fixedTicks);
+    };
+    if (onTickBatch) {
+        binary::parse(bytes, size, batch, fieldMasks);
+        onTickBatch(this, batch);
     };
-    return ticks;
 };
 
 inline void ticker::resubInstruments() {
-    std::vector<int> ltpInstruments;
-    std::vector<int> quoteInstruments;
-    std::vector<int> fullInstruments;
-    for (const auto& i : subbedInstruments) {
-        if (i.second == MODES::LTP) { ltpInstruments.push_back(i.first); };
-        if (i.second == MODES::QUOTE) { quoteInstruments.push_back(i.first); };
-        if (i.second == MODES::FULL) { fullInstruments.push_back(i.first); };
+    const internal::subscriptionTable& table = subbedInstruments.getTable();
+    internal::subscriptionChanges changes;
+    changes.subscribed.assign(
+        table.getTokens().begin(), table.getTokens().end());
+    for (uint32_t slot = 0; slot < table.size(); slot++) {
+        // instruments are subscribed in `quote` mode
+        if (table.mode(slot) == kc::TICK_MODE::QUOTE) { continue; };
+        changes.modes[static_cast<size_t>(table.mode(slot))].push_back(
+            table.token(slot));
     };
-
-    if (!ltpInstruments.empty()) { setMode(MODE_LTP, ltpInstruments); };
-    if (!quoteInstruments.empty()) { setMode(MODE_QUOTE, quoteInstruments); };
-    if (!fullInstruments.empty()) { setMode(MODE_FULL, fullInstruments); };
+    sendChanges(changes);
 };
 
 inline void ticker::assignCallbacks() {
@@ -378,25 +622,34 @@ inline void ticker::assignCallbacks() {
             //! when conected since pongTime would be far back
             lastPongTime = std::chrono::system_clock::now();
 
+            if (isReconnecting && onReconnect) {
+                onReconnect(this, reconnectTries,
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - disconnectTime));
+            };
             reconnectTries = 0;
-            reconnectDelay = initReconnectDelay;
             isReconnecting = false;
+            control.clear();
             if (!subbedInstruments.empty()) { resubInstruments(); };
+            if (fetchOrders) { loadOrders(); };
             if (onConnect) { onConnect(this); };
         });
 
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
     group->onMessage([&](uWS::WebSocket<uWS::CLIENT>* /*ws*/, char* message,
                          size_t length, uWS::OpCode opCode) {
-        if (opCode == uWS::OpCode::BINARY && onTicks) {
+        if (hasFetchedOrders.load(std::memory_order_relaxed)) {
+            applyFetchedOrders();
+        };
+        if (opCode == uWS::OpCode::BINARY) {
             if (length == 1) {
                 // is a heartbeat
                 lastBeatTime = std::chrono::system_clock::now();
             } else {
-                onTicks(this, parseBinaryMessage(message, length));
+                processBinaryMessage(message, length);
             };
         } else if (opCode == uWS::OpCode::TEXT) {
-            processTextMessage(string(message, length));
+            processTextMessage(message, length);
         };
     });
 
@@ -417,6 +670,8 @@ inline void ticker::assignCallbacks() {
     group->onDisconnection([&](uWS::WebSocket<uWS::CLIENT>* /*ws*/, int code,
                                char* reason, size_t length) {
         ws = nullptr;
+        cancelControl();
+        control.clear();
 
         if (code != utils::ws::ERROR_CODE::NORMAL_CLOSURE) {
             if (onError) { onError(this, code, string(reason, length)); };
@@ -0,0 +1,290 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../span.hpp"
+#include "ring.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+/// How consumers of a `multicastRing` wait for ticks.
+enum class WAIT_STRATEGY
+{
+    /// spin on the CPU, lowest latency
+    BUSY_SPIN,
+    /// spin, yielding the CPU to other threads in between
+    YIELD,
+    /// sleep until woken up by the producer, lowest CPU usage
+    BLOCK
+};
+
+///
+/// @brief Ring of ticks published once and read by several consumers, each
+///        at its own pace, in the style of the LMAX disruptor.
+///
+/// Every consumer has its own cursor and reads ticks in place; ticks are
+/// never copied per consumer. The producer never waits: a batch that doesn't
+/// fit behind the slowest consumer is dropped and counted in `stats()`.
+///
+class multicastRing {
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  public:
+    ///
+    /// @brief A consumer of the ring. Should only be used by one thread.
+    ///
+    class consumer {
+
+      public:
+        explicit consumer(multicastRing& Ring, size_t Cursor)
+            : ring(Ring), cursor(Cursor) {};
+
+        ///
+        /// @brief Call \a fn with the ticks published since the last call,
+        ///        without waiting.
+        ///
+        /// @param fn called with one or two contiguous batches of ticks.
+        ///           The ticks are only valid until \a fn returns.
+        ///
+        /// @return size_t number of ticks consumed
+        ///
+        template <class Fn>
+        size_t tryConsume(Fn&& fn) {
+            const size_t start = cursor.load(std::memory_order_relaxed);
+            const size_t end =
+                ring.published.load(std::memory_order_acquire);
+            if (start == end) { return 0; };
+
+            const size_t first = start & ring.mask;
+            const size_t count = end - start;
+            // the lag of the slowest consumer is the ring's depth
+            if (count > highWaterMark.load(std::memory_order_relaxed)) {
+                highWaterMark.store(count, std::memory_order_relaxed);
+            };
+            const size_t untilWrap = std::min(count, ring.capacity - first);
+            fn(kc::span<const kc::compactTick>(
+                ring.slots.get() + first, untilWrap));
+            if (untilWrap < count) {
+                fn(kc::span<const kc::compactTick>(
+                    ring.slots.get(), count - untilWrap));
+            };
+            // frees the slots for the producer
+            cursor.store(end, std::memory_order_release);
+            return count;
+        };
+
+        ///
+        /// @brief Like `tryConsume()`, but waits for ticks as set by the
+        ///        ring's wait strategy.
+        ///
+        /// @return size_t number of ticks consumed, 0 once the ring is
+        ///         closed and every tick was consumed
+        ///
+        template <class Fn>
+        size_t consume(Fn&& fn) {
+            while (true) {
+                // read before consuming so ticks published before
+                // `close()` are handled
+                const bool closed = ring.closed.load(std::memory_order_acquire);
+                const size_t consumed = tryConsume(fn);
+                if (consumed > 0 || closed) { return consumed; };
+                ring.wait(cursor.load(std::memory_order_relaxed));
+            };
+        };
+
+      private:
+        friend class multicastRing;
+        multicastRing& ring;
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> cursor;
+        // largest number of ticks found waiting by `tryConsume()`
+        std::atomic<size_t> highWaterMark { 0 };
+    };
+
+    ///
+    /// @brief Construct a new ring.
+    ///
+    /// @param Capacity minimum number of ticks the ring can hold, rounded up
+    ///                 to a power of two
+    /// @param Strategy how consumers wait for ticks
+    ///
+    explicit multicastRing(
+        size_t Capacity, WAIT_STRATEGY Strategy = WAIT_STRATEGY::YIELD)
+        : strategy(Strategy) {
+        if (Capacity == 0) {
+            throw kc::libException("capacity of a ring can't be 0");
+        };
+        while (capacity < Capacity) { capacity <<= 1U; };
+        mask = capacity - 1;
+        slots = std::make_unique<kc::compactTick[]>(capacity);
+    };
+
+    multicastRing(const multicastRing&) = delete;
+    multicastRing& operator=(const multicastRing&) = delete;
+
+    ///
+    /// @brief Register a new consumer. All consumers should be added before
+    ///        the first tick is published.
+    ///
+    /// @return consumer& consumer, valid as long as the ring is
+    ///
+    consumer& addConsumer() {
+        if (published.load(std::memory_order_relaxed) != 0) {
+            throw kc::libException(
+                "consumers should be added before publishing");
+        };
+        consumers.push_back(std::make_unique<consumer>(*this, 0));
+        return *consumers.back();
+    };
+
+    ///
+    /// @brief Publish \a ticks to every consumer. Should only be called by
+    ///        one thread.
+    ///
+    /// @return bool `false` if there wasn't room for \a ticks and they were
+    ///         dropped
+    ///
+    bool publish(kc::span<const kc::compactTick> ticks) {
+        const size_t start = published.load(std::memory_order_relaxed);
+        if (capacity - (start - gatingCursor) < ticks.size()) {
+            gatingCursor = slowestCursor(start);
+            if (capacity - (start - gatingCursor) < ticks.size()) {
+                dropped.fetch_add(ticks.size(), std::memory_order_relaxed);
+                return false;
+            };
+        };
+        for (size_t i = 0; i < ticks.size(); i++) {
+            slots[(start + i) & mask] = ticks[i];
+        };
+        published.store(start + ticks.size(), std::memory_order_release);
+        pushed.fetch_add(ticks.size(), std::memory_order_relaxed);
+        if (strategy == WAIT_STRATEGY::BLOCK) { wakeUp(); };
+        return true;
+    };
+
+    /// @brief Wake up consumers and have `consumer::consume()` return 0 once
+    ///        they have consumed everything published so far.
+    void close() {
+        closed.store(true, std::memory_order_release);
+        wakeUp();
+    };
+
+    /// @brief Get the number of registered consumers.
+    size_t getConsumerCount() const { return consumers.size(); };
+
+    ///
+    /// @brief Get a snapshot of the ring's metrics. `depth` is the number of
+    ///        ticks the slowest consumer hasn't consumed yet and
+    ///        `highWaterMark` the largest such number seen so far, sampled
+    ///        by consumers as they consume.
+    ///
+    kc::queueStats stats() const {
+        kc::queueStats Stats;
+        const size_t end = published.load(std::memory_order_acquire);
+        Stats.capacity = capacity;
+        Stats.depth = end - slowestCursor(end);
+        Stats.pushed = pushed.load(std::memory_order_relaxed);
+        Stats.dropped = dropped.load(std::memory_order_relaxed);
+        // a stalled consumer doesn't sample its lag
+        Stats.highWaterMark = Stats.depth;
+        for (const auto& Consumer : consumers) {
+            Stats.highWaterMark = std::max(Stats.highWaterMark,
+                Consumer->highWaterMark.load(std::memory_order_relaxed));
+        };
+        return Stats;
+    };
+
+  private:
+    const WAIT_STRATEGY strategy;
+    size_t capacity = 1;
+    size_t mask = 0;
+    std::unique_ptr<kc::compactTick[]> slots;
+    std::vector<std::unique_ptr<consumer>> consumers;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> published { 0 };
+    // producer's cached copy of the slowest consumer's cursor
+    size_t gatingCursor = 0;
+    std::atomic<uint64_t> pushed { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<bool> closed { false };
+    // used by `WAIT_STRATEGY::BLOCK` only
+    std::mutex mutex;
+    std::condition_variable wakeUpCondition;
+    std::atomic<size_t> sleepers { 0 };
+
+    size_t slowestCursor(size_t end) const {
+        size_t slowest = end;
+        for (const auto& Consumer : consumers) {
+            slowest = std::min(
+                slowest, Consumer->cursor.load(std::memory_order_acquire));
+        };
+        return slowest;
+    };
+
+    void wait(size_t cursor) {
+        switch (strategy) {
+            case WAIT_STRATEGY::BUSY_SPIN: break;
+            case WAIT_STRATEGY::YIELD: std::this_thread::yield(); break;
+            case WAIT_STRATEGY::BLOCK: {
+                std::unique_lock<std::mutex> lock(mutex);
+                sleepers.fetch_add(1, std::memory_order_seq_cst);
+                wakeUpCondition.wait(lock, [this, cursor]() {
+                    return published.load(std::memory_order_seq_cst) !=
+                               cursor ||
+                           closed.load(std::memory_order_seq_cst);
+                });
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            };
+        };
+    };
+
+    void wakeUp() {
+        // `published` & `closed` are release stores, which a later load can
+        // be reordered before; the fence orders them with the load of
+        // `sleepers`, so that a consumer going to sleep in `wait()` either
+        // sees the new ticks or is seen here
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) == 0) { return; };
+        { const std::lock_guard<std::mutex> lock(mutex); };
+        wakeUpCondition.notify_all();
+    };
+};
+
+} // namespace kiteconnect
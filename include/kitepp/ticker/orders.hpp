@@ -0,0 +1,361 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/order.hpp"
+#include "../responses/ws.hpp"
+#include "../userconstants.hpp"
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// @brief State of an order kept by `orderBook`. Text fields are
+///        NUL-terminated and cut to fit, see `orderState::text()`.
+///
+struct orderState {
+    static constexpr size_t ID_SIZE = 24;
+    static constexpr size_t STATUS_SIZE = 32;
+    static constexpr size_t SYMBOL_SIZE = 32;
+    static constexpr size_t CODE_SIZE = 8;
+    // "2022-03-03 09:24:25"
+    static constexpr size_t TIMESTAMP_SIZE = 20;
+
+    orderState() = default;
+    explicit orderState(const kc::postback& Postback);
+    explicit orderState(const kc::order& Order);
+
+    /// @brief Get \a field as a string.
+    template <size_t N>
+    static std::string_view text(const std::array<char, N>& field) {
+        const auto* end = std::find(field.begin(), field.end(), '\0');
+        return { field.data(), static_cast<size_t>(end - field.begin()) };
+    };
+
+    /// @brief Check if the order is complete, rejected or cancelled, after
+    ///        which its state doesn't change.
+    bool isFinal() const {
+        const std::string_view Status = text(status);
+        return Status == STATUS_COMPLETE || Status == STATUS_REJECTED ||
+               Status == STATUS_CANCELLED;
+    };
+
+    int quantity = 0;
+    int filledQuantity = 0;
+    int pendingQuantity = 0;
+    double price = 0;
+    double triggerPrice = 0;
+    double averagePrice = 0;
+    std::array<char, ID_SIZE> orderId {};
+    std::array<char, ID_SIZE> exchangeOrderId {};
+    std::array<char, STATUS_SIZE> status {};
+    std::array<char, SYMBOL_SIZE> tradingSymbol {};
+    std::array<char, CODE_SIZE> exchange {};
+    std::array<char, CODE_SIZE> transactionType {};
+    std::array<char, CODE_SIZE> orderType {};
+    std::array<char, CODE_SIZE> product {};
+    std::array<char, TIMESTAMP_SIZE> exchangeTimestamp {};
+};
+static_assert(std::is_trivially_copyable_v<orderState>);
+
+namespace internal::orders {
+
+template <size_t N>
+void copy(std::array<char, N>& field, const string& value) {
+    const size_t length = std::min(value.size(), N - 1);
+    std::memcpy(field.data(), value.data(), length);
+    field[length] = '\0';
+};
+
+} // namespace internal::orders
+
+inline orderState::orderState(const kc::postback& Postback)
+    : quantity(Postback.quantity), filledQuantity(Postback.filledQuantity),
+      pendingQuantity(Postback.unfilledQuantity), price(Postback.price),
+      triggerPrice(Postback.triggerPrice),
+      averagePrice(Postback.averagePrice) {
+    namespace orders = internal::orders;
+    orders::copy(orderId, Postback.orderId);
+    orders::copy(exchangeOrderId, Postback.exchangeOrderId);
+    orders::copy(status, Postback.status);
+    orders::copy(tradingSymbol, Postback.tradingSymbol);
+    orders::copy(exchange, Postback.exchange);
+    orders::copy(transactionType, Postback.transactionType);
+    orders::copy(orderType, Postback.orderType);
+    orders::copy(product, Postback.product);
+    orders::copy(exchangeTimestamp, Postback.exchangeTimestamp);
+};
+
+inline orderState::orderState(const kc::order& Order)
+    : quantity(Order.quantity), filledQuantity(Order.filledQuantity),
+      pendingQuantity(Order.pendingQuantity), price(Order.price),
+      triggerPrice(Order.triggerPrice), averagePrice(Order.averagePrice) {
+    namespace orders = internal::orders;
+    orders::copy(orderId, Order.orderID);
+    orders::copy(exchangeOrderId, Order.exchangeOrderID);
+    orders::copy(status, Order.status);
+    orders::copy(tradingSymbol, Order.tradingsymbol);
+    orders::copy(exchange, Order.exchange);
+    orders::copy(transactionType, Order.transactionType);
+    orders::copy(orderType, Order.orderType);
+    orders::copy(product, Order.product);
+    orders::copy(exchangeTimestamp, Order.exchangeTimestamp);
+};
+
+///
+/// @brief Keeps the current state of every order, built from order updates.
+///        Written by a single thread and read by any number of threads,
+///        without locks.
+///
+/// Updates are applied only if they move an order forward: updates of
+/// complete, rejected or cancelled orders are dropped, as are updates with an
+/// older exchange timestamp than the one applied last, updates of the same
+/// second that report fewer filled quantities and duplicates. Applying an
+/// update again thus changes nothing.
+///
+/// Orders are stored like ticks in `lastValueCache`: in an open addressing
+/// table whose slots are never freed, each guarded by a sequence lock.
+///
+class orderBook {
+
+  public:
+    ///
+    /// @brief Construct a new order book.
+    ///
+    /// @param MaxOrders maximum number of orders the book can hold. Updates
+    ///                  of further orders are dropped and counted by
+    ///                  `getDropped()`.
+    ///
+    explicit orderBook(size_t MaxOrders) : maxOrders(MaxOrders) {
+        if (MaxOrders == 0) {
+            throw kc::libException("order book must hold at least one order");
+        };
+        // keep the load factor at 0.5 or below so probes stay short
+        while (tableSize < MaxOrders * 2) { tableSize <<= 1U; };
+        keys = std::make_unique<std::atomic<uint64_t>[]>(tableSize);
+        for (size_t i = 0; i < tableSize; i++) {
+            keys[i].store(EMPTY, std::memory_order_relaxed);
+        };
+        slots = std::make_unique<slot[]>(tableSize);
+        states.resize(tableSize);
+    };
+
+    orderBook(const orderBook&) = delete;
+    orderBook& operator=(const orderBook&) = delete;
+
+    ///
+    /// @brief Apply \a state to its order. Should only be called by one
+    ///        thread.
+    ///
+    /// @return bool `false` if the update was dropped
+    ///
+    bool update(const orderState& state) {
+        const std::string_view id = orderState::text(state.orderId);
+        if (id.empty()) { return false; };
+        const uint64_t key = hash(id);
+        size_t idx = key & (tableSize - 1);
+        while (true) {
+            const uint64_t found = keys[idx].load(std::memory_order_relaxed);
+            if (found == key && orderState::text(states[idx].orderId) == id) {
+                if (!isNewer(state, states[idx])) {
+                    stale.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                };
+                states[idx] = state;
+                write(slots[idx], state);
+                return true;
+            };
+            if (found == EMPTY) {
+                if (orders.load(std::memory_order_relaxed) == maxOrders) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                };
+                states[idx] = state;
+                write(slots[idx], state);
+                // publishes the slot along with its first state
+                keys[idx].store(key, std::memory_order_release);
+                orders.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            };
+            idx = (idx + 1) & (tableSize - 1);
+        };
+    };
+
+    /// @brief Apply an order update received on the websocket.
+    bool update(const kc::postback& Postback) {
+        return update(orderState(Postback));
+    };
+
+    /// @brief Apply the state of \a Orders, e.g., as returned by
+    ///        `kite::orders()`.
+    void load(const std::vector<kc::order>& Orders) {
+        for (const kc::order& Order : Orders) { update(orderState(Order)); };
+    };
+
+    ///
+    /// @brief Get the current state of \a orderId. Can be called by any
+    ///        thread.
+    ///
+    /// @param orderId order ID
+    /// @param state   set to a consistent copy of the order's state
+    ///
+    /// @return bool `false` if no update of \a orderId was seen yet
+    ///
+    bool get(std::string_view orderId, orderState& state) const {
+        if (orderId.empty()) { return false; };
+        const uint64_t key = hash(orderId);
+        size_t idx = key & (tableSize - 1);
+        for (size_t probes = 0; probes < tableSize; probes++) {
+            const uint64_t found = keys[idx].load(std::memory_order_acquire);
+            if (found == EMPTY) { return false; };
+            if (found == key) {
+                read(slots[idx], state);
+                if (orderState::text(state.orderId) == orderId) {
+                    return true;
+                };
+            };
+            idx = (idx + 1) & (tableSize - 1);
+        };
+        return false;
+    };
+
+    /// @brief Get the number of orders in the book.
+    size_t getSize() const { return orders.load(std::memory_order_relaxed); };
+
+    /// @brief Get the number of updates dropped because the book was full.
+    uint64_t getDropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the number of updates dropped as duplicate or out of
+    ///        order.
+    uint64_t getStale() const { return stale.load(std::memory_order_relaxed); };
+
+  private:
+    static constexpr uint64_t EMPTY = 0;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t WORDS =
+        (sizeof(orderState) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct alignas(CACHE_LINE_SIZE) slot {
+        std::atomic<uint64_t> sequence { 0 };
+        std::array<std::atomic<uint64_t>, WORDS> words {};
+    };
+
+    const size_t maxOrders;
+    size_t tableSize = 1;
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;
+    std::unique_ptr<slot[]> slots;
+    // the writer's copy of every slot, so that it never reads a slot back
+    std::vector<orderState> states;
+    std::atomic<size_t> orders { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<uint64_t> stale { 0 };
+
+    // FNV-1a, never `EMPTY`
+    static uint64_t hash(std::string_view orderId) {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        uint64_t value = 0xcbf29ce484222325ULL;
+        for (const char c : orderId) {
+            value ^= static_cast<uint8_t>(c);
+            // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+            value *= 0x100000001b3ULL;
+        };
+        return value == EMPTY ? 1 : value;
+    };
+
+    static bool isNewer(const orderState& next, const orderState& current) {
+        if (current.isFinal()) { return false; };
+        // timestamps have a fixed format & compare as strings; orders that
+        // haven't reached the exchange yet have none
+        const int order = orderState::text(next.exchangeTimestamp)
+                              .compare(orderState::text(
+                                  current.exchangeTimestamp));
+        if (order != 0) { return order > 0; };
+        if (next.filledQuantity != current.filledQuantity) {
+            return next.filledQuantity > current.filledQuantity;
+        };
+        return !isSame(next, current);
+    };
+
+    static bool isSame(const orderState& next, const orderState& current) {
+        return next.quantity == current.quantity &&
+               next.pendingQuantity == current.pendingQuantity &&
+               next.price == current.price &&
+               next.triggerPrice == current.triggerPrice &&
+               next.averagePrice == current.averagePrice &&
+               next.status == current.status &&
+               next.exchangeOrderId == current.exchangeOrderId;
+    };
+
+    static void write(slot& Slot, const orderState& state) {
+        std::array<uint64_t, WORDS> words {};
+        std::memcpy(words.data(), &state, sizeof(orderState));
+        const uint64_t sequence =
+            Slot.sequence.load(std::memory_order_relaxed);
+        // odd while writing
+        Slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            Slot.words[i].store(words[i], std::memory_order_relaxed);
+        };
+        Slot.sequence.store(sequence + 2, std::memory_order_release);
+    };
+
+    static void read(const slot& Slot, orderState& state) {
+        std::array<uint64_t, WORDS> words {};
+        while (true) {
+            const uint64_t before =
+                Slot.sequence.load(std::memory_order_acquire);
+            if ((before & 1U) != 0) { continue; };
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = Slot.words[i].load(std::memory_order_relaxed);
+            };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Slot.sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            };
+        };
+        std::memcpy(static_cast<void*>(&state), words.data(), sizeof(state));
+    };
+};
+
+} // namespace kiteconnect
@@ -0,0 +1,518 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../responses/ws.hpp"
+#include "../userconstants.hpp" //modes
+#include "binary.hpp"
+#include "simd.hpp"
+#include "subscriptions.hpp"
+
+namespace kiteconnect::internal::binary {
+
+namespace kc = kiteconnect;
+
+/// @brief Get the divisor prices of \a instrumentToken are scaled by.
+inline double priceDivisor(int32_t instrumentToken) {
+    static constexpr uint8_t SEGMENT_MASK = 0xff;
+    static constexpr double CDS_DIVISOR = 10000000.0;
+    static constexpr double BSECDS_DIVISOR = 10000.0;
+    static constexpr double GENERIC_DIVISOR = 100.0;
+
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    const uint8_t segment = instrumentToken & SEGMENT_MASK;
+    if (segment == static_cast<uint8_t>(SEGMENTS::CDS)) {
+        return CDS_DIVISOR;
+    };
+    if (segment == static_cast<uint8_t>(SEGMENTS::BSECDS)) {
+        return BSECDS_DIVISOR;
+    };
+    return GENERIC_DIVISOR;
+};
+
+///
+/// @brief Get the power of ten prices of \a instrumentToken are scaled by,
+///        i.e., the `fixedTick::priceExponent` matching `priceDivisor()`.
+///
+inline int8_t priceExponent(int32_t instrumentToken) {
+    static constexpr uint8_t SEGMENT_MASK = 0xff;
+    static constexpr int8_t CDS_EXPONENT = -7;
+    static constexpr int8_t BSECDS_EXPONENT = -4;
+    static constexpr int8_t GENERIC_EXPONENT = -2;
+
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    const uint8_t segment = instrumentToken & SEGMENT_MASK;
+    if (segment == static_cast<uint8_t>(SEGMENTS::CDS)) {
+        return CDS_EXPONENT;
+    };
+    if (segment == static_cast<uint8_t>(SEGMENTS::BSECDS)) {
+        return BSECDS_EXPONENT;
+    };
+    return GENERIC_EXPONENT;
+};
+
+/// @brief Check whether \a instrumentToken belongs to a tradable segment.
+inline bool isTradable(int32_t instrumentToken) {
+    static constexpr uint8_t SEGMENT_MASK = 0xff;
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    const uint8_t segment = instrumentToken & SEGMENT_MASK;
+    return segment != static_cast<uint8_t>(SEGMENTS::INDICES);
+};
+
+/// @brief Set the mode of a `kc::tick`.
+inline void setMode(kc::tick& Tick, kc::TICK_MODE mode) {
+    switch (mode) {
+        case kc::TICK_MODE::LTP: Tick.mode = MODE_LTP; break;
+        case kc::TICK_MODE::QUOTE: Tick.mode = MODE_QUOTE; break;
+        case kc::TICK_MODE::FULL: Tick.mode = MODE_FULL; break;
+    };
+};
+
+/// @brief Set the mode of a `kc::compactTick`.
+inline void setMode(kc::compactTick& Tick, kc::TICK_MODE mode) {
+    Tick.mode = mode;
+};
+
+/// @brief Set the mode of a `kc::fixedTick`.
+inline void setMode(kc::fixedTick& Tick, kc::TICK_MODE mode) {
+    Tick.mode = mode;
+};
+
+/// Whether prices of \a Tick are left unscaled.
+template <class Tick>
+constexpr bool IS_FIXED_POINT = std::is_same_v<Tick, kc::fixedTick>;
+
+/// @brief Scale \a price the way prices of \a Tick are stored.
+template <class Tick>
+auto scalePrice(int32_t price, double divisor) {
+    if constexpr (IS_FIXED_POINT<Tick>) {
+        return price;
+    } else {
+        return price / divisor;
+    };
+};
+
+///
+/// @brief Decode the fields in \a fields of the header of a quote packet into
+///        a `kc::fixedTick`.
+///
+inline void decodeFixedQuoteHeader(
+    const char* packet, uint32_t fields, kc::fixedTick& tick) {
+    using Layout = layout::quote;
+    tick.lastPrice = unpack<int32_t>(packet + Layout::LAST_PRICE);
+    if ((fields & kc::FIELDS_VOLUME) != 0) {
+        tick.volumeTraded = unpack<int32_t>(packet + Layout::VOLUME_TRADED);
+    };
+    if ((fields & kc::FIELDS_QUOTE) != 0) {
+        tick.lastTradedQuantity =
+            unpack<int32_t>(packet + Layout::LAST_TRADED_QUANTITY);
+        tick.averageTradePrice =
+            unpack<int32_t>(packet + Layout::AVERAGE_TRADE_PRICE);
+        tick.totalBuyQuantity =
+            unpack<int32_t>(packet + Layout::TOTAL_BUY_QUANTITY);
+        tick.totalSellQuantity =
+            unpack<int32_t>(packet + Layout::TOTAL_SELL_QUANTITY);
+    };
+    if ((fields & kc::FIELDS_OHLC) != 0) {
+        tick.ohlc.open = unpack<int32_t>(packet + Layout::OPEN);
+        tick.ohlc.high = unpack<int32_t>(packet + Layout::HIGH);
+        tick.ohlc.low = unpack<int32_t>(packet + Layout::LOW);
+        tick.ohlc.close = unpack<int32_t>(packet + Layout::CLOSE);
+        tick.netChange = tick.lastPrice - tick.ohlc.close;
+    };
+};
+
+/// @brief Decode the market depth of a full packet into a `kc::fixedTick`.
+inline void decodeFixedDepth(const char* depth, kc::fixedTick& tick) {
+    using Layout = layout::full;
+    static_assert(kc::fixedTick::DEPTH_ENTRIES_PER_SIDE ==
+                  Layout::DEPTH_ENTRIES / 2);
+    for (size_t i = 0; i < Layout::DEPTH_ENTRIES; i++) {
+        const char* entry = depth + (i * Layout::DEPTH_ENTRY_SIZE);
+        kc::fixedDepthWS& Entry =
+            (i < kc::fixedTick::DEPTH_ENTRIES_PER_SIDE) ?
+                tick.marketDepth.buy[i] :
+                tick.marketDepth
+                    .sell[i - kc::fixedTick::DEPTH_ENTRIES_PER_SIDE];
+        Entry.quantity = unpack<int32_t>(entry + Layout::DEPTH_QUANTITY);
+        Entry.price = unpack<int32_t>(entry + Layout::DEPTH_PRICE);
+        Entry.orders = unpack<int16_t>(entry + Layout::DEPTH_ORDERS);
+    };
+};
+
+///
+/// @brief Get the market depth entries of a `kc::tick`, sized to hold a full
+///        packet's depth.
+///
+/// @return std::pair<kc::depthWS*, kc::depthWS*> first buy & sell entries
+///
+inline std::pair<kc::depthWS*, kc::depthWS*> depthEntries(kc::tick& Tick) {
+    constexpr size_t entriesPerSide = layout::full::DEPTH_ENTRIES / 2;
+    Tick.marketDepth.buy.resize(entriesPerSide);
+    Tick.marketDepth.sell.resize(entriesPerSide);
+    return { Tick.marketDepth.buy.data(), Tick.marketDepth.sell.data() };
+};
+
+/// \copydoc depthEntries(kc::tick&)
+inline std::pair<kc::depthWS*, kc::depthWS*> depthEntries(
+    kc::compactTick& Tick) {
+    static_assert(kc::compactTick::DEPTH_ENTRIES_PER_SIDE ==
+                  layout::full::DEPTH_ENTRIES / 2);
+    return { Tick.marketDepth.buy.data(), Tick.marketDepth.sell.data() };
+};
+
+/// @brief Parse a packet of an index in quote or full mode.
+template <class Layout, class Tick>
+void parseIndicesPacket(
+    const packetView& packet, double divisor, uint32_t fields, Tick& tick) {
+    setMode(tick, std::is_same_v<Layout, layout::indicesQuote> ?
+                      kc::TICK_MODE::QUOTE :
+                      kc::TICK_MODE::FULL);
+    tick.lastPrice = scalePrice<Tick>(
+        packet.field<Layout, Layout::LAST_PRICE>(), divisor);
+    if ((fields & kc::FIELDS_OHLC) != 0) {
+        tick.ohlc.high = scalePrice<Tick>(
+            packet.field<Layout, Layout::HIGH>(), divisor);
+        tick.ohlc.low = scalePrice<Tick>(
+            packet.field<Layout, Layout::LOW>(), divisor);
+        tick.ohlc.open = scalePrice<Tick>(
+            packet.field<Layout, Layout::OPEN>(), divisor);
+        tick.ohlc.close = scalePrice<Tick>(
+            packet.field<Layout, Layout::CLOSE>(), divisor);
+        tick.netChange = scalePrice<Tick>(
+            packet.field<Layout, Layout::NET_CHANGE>(), divisor);
+    };
+    if constexpr (std::is_same_v<Layout, layout::indicesFull>) {
+        if ((fields & kc::FIELDS_TIMESTAMPS) != 0) {
+            tick.timestamp = packet.field<Layout, Layout::TIMESTAMP>();
+        };
+    };
+};
+
+///
+/// @brief Decode the fields in \a fields of the header of a quote packet into
+///        a floating point tick.
+///
+template <class Tick>
+void parseQuoteHeader(
+    const packetView& packet, double divisor, uint32_t fields, Tick& tick) {
+    using Layout = layout::quote;
+    if ((fields & (kc::FIELDS_QUOTE | kc::FIELDS_OHLC)) == 0) {
+        // not worth decoding the whole header for these
+        tick.lastPrice = scalePrice<Tick>(
+            packet.field<Layout, Layout::LAST_PRICE>(), divisor);
+        if ((fields & kc::FIELDS_VOLUME) != 0) {
+            tick.volumeTraded = packet.field<Layout, Layout::VOLUME_TRADED>();
+        };
+        return;
+    };
+
+    quoteHeader header;
+    decodeQuoteHeader(packet.data(), divisor, header);
+    tick.lastPrice = header.prices[quoteHeader::LAST_PRICE];
+    if ((fields & kc::FIELDS_VOLUME) != 0) {
+        tick.volumeTraded = header.volumeTraded;
+    };
+    if ((fields & kc::FIELDS_QUOTE) != 0) {
+        tick.lastTradedQuantity = header.lastTradedQuantity;
+        tick.averageTradePrice =
+            header.prices[quoteHeader::AVERAGE_TRADE_PRICE];
+        tick.totalBuyQuantity = header.totalBuyQuantity;
+        tick.totalSellQuantity = header.totalSellQuantity;
+    };
+    if ((fields & kc::FIELDS_OHLC) != 0) {
+        tick.ohlc.open = header.prices[quoteHeader::OPEN];
+        tick.ohlc.high = header.prices[quoteHeader::HIGH];
+        tick.ohlc.low = header.prices[quoteHeader::LOW];
+        tick.ohlc.close = header.prices[quoteHeader::CLOSE];
+        tick.netChange =
+            // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+            (tick.lastPrice - tick.ohlc.close) * 100 / tick.ohlc.close;
+    };
+};
+
+/// @brief Parse a packet of a tradable instrument in quote or full mode.
+template <class Layout, class Tick>
+void parseQuotePacket(
+    const packetView& packet, double divisor, uint32_t fields, Tick& tick) {
+    static_assert(Layout::SIZE >= layout::quote::SIZE);
+    setMode(tick, std::is_same_v<Layout, layout::quote> ?
+                      kc::TICK_MODE::QUOTE :
+                      kc::TICK_MODE::FULL);
+
+    if constexpr (IS_FIXED_POINT<Tick>) {
+        decodeFixedQuoteHeader(packet.data(), fields, tick);
+    } else {
+        parseQuoteHeader(packet, divisor, fields, tick);
+    };
+
+    if constexpr (std::is_same_v<Layout, layout::full>) {
+        if ((fields & kc::FIELDS_TIMESTAMPS) != 0) {
+            tick.lastTradeTime =
+                packet.field<Layout, Layout::LAST_TRADE_TIME>();
+            tick.timestamp = packet.field<Layout, Layout::TIMESTAMP>();
+        };
+        if ((fields & kc::FIELDS_OI) != 0) {
+            tick.oi = packet.field<Layout, Layout::OI>();
+            tick.oiDayHigh = packet.field<Layout, Layout::OI_DAY_HIGH>();
+            tick.oiDayLow = packet.field<Layout, Layout::OI_DAY_LOW>();
+        };
+        if ((fields & kc::FIELDS_DEPTH) != 0) {
+            if constexpr (IS_FIXED_POINT<Tick>) {
+                decodeFixedDepth(packet.data() + Layout::DEPTH, tick);
+            } else {
+                const auto [buy, sell] = depthEntries(tick);
+                decodeDepth(
+                    packet.data() + Layout::DEPTH, divisor, buy, sell);
+            };
+        };
+    };
+};
+
+///
+/// @brief Fields to decode for each instrument, see `kc::FIELDS_ALL` and
+///        friends.
+///
+struct fieldMasks {
+    /// fields decoded for instruments without a mask of their own
+    uint32_t defaultFields = kc::FIELDS_ALL;
+
+    /// @brief Set the fields that should be decoded for \a instrumentToken.
+    void set(int32_t instrumentToken, uint32_t fields) {
+        const auto [slot, added] = index.insert(instrumentToken);
+        if (added) {
+            instrumentFields.push_back(fields);
+        } else {
+            instrumentFields[slot] = fields;
+        };
+    };
+
+    /// @brief Get the fields that should be decoded for \a instrumentToken.
+    uint32_t get(int32_t instrumentToken) const {
+        if (index.empty()) { return defaultFields; };
+        const uint32_t slot = index.find(instrumentToken);
+        return (slot == tokenIndex::NOT_FOUND) ? defaultFields :
+                                                 instrumentFields[slot];
+    };
+
+  private:
+    tokenIndex index;
+    // indexed by slot
+    std::vector<uint32_t> instrumentFields;
+};
+
+///
+/// @brief Parse a single packet into \a tick.
+///
+/// @tparam Tick `kc::tick`, `kc::compactTick` or `kc::fixedTick`
+///
+template <class Tick>
+void parsePacket(const packetView& packet, Tick& tick,
+    const fieldMasks& masks = fieldMasks()) {
+    const auto instrumentToken = packet.get<int32_t>(0);
+    const double divisor = priceDivisor(instrumentToken);
+    const uint32_t fields = masks.get(instrumentToken);
+    tick.isTradable = isTradable(instrumentToken);
+    tick.instrumentToken = instrumentToken;
+    if constexpr (IS_FIXED_POINT<Tick>) {
+        tick.priceExponent = priceExponent(instrumentToken);
+    };
+
+    switch (packet.size()) {
+        case layout::ltp::SIZE:
+            setMode(tick, kc::TICK_MODE::LTP);
+            tick.lastPrice = scalePrice<Tick>(
+                packet.field<layout::ltp, layout::ltp::LAST_PRICE>(), divisor);
+            break;
+        case layout::indicesQuote::SIZE:
+            parseIndicesPacket<layout::indicesQuote>(
+                packet, divisor, fields, tick);
+            break;
+        case layout::indicesFull::SIZE:
+            parseIndicesPacket<layout::indicesFull>(
+                packet, divisor, fields, tick);
+            break;
+        case layout::quote::SIZE:
+            parseQuotePacket<layout::quote>(packet, divisor, fields, tick);
+            break;
+        case layout::full::SIZE:
+            parseQuotePacket<layout::full>(packet, divisor, fields, tick);
+            break;
+        default: break;
+    };
+};
+
+/// @brief Reset \a Tick to a default constructed tick.
+template <class Tick>
+void resetTick(Tick& tick) {
+    static_assert(std::is_trivially_copyable_v<Tick>);
+    tick = Tick();
+};
+
+///
+/// @brief Reset \a Tick to a default constructed tick while keeping the
+///        capacity of its market depth vectors.
+///
+inline void resetTick(kc::tick& Tick) {
+    std::vector<kc::depthWS> buy = std::move(Tick.marketDepth.buy);
+    std::vector<kc::depthWS> sell = std::move(Tick.marketDepth.sell);
+    buy.clear();
+    sell.clear();
+    Tick = kc::tick();
+    Tick.marketDepth.buy = std::move(buy);
+    Tick.marketDepth.sell = std::move(sell);
+};
+
+///
+/// @brief Parse a binary message into the front of \a buffer, growing it if
+///        needed. Unlike `parse()`, elements of \a buffer are overwritten in
+///        place rather than destroyed, so a `kc::tick` buffer reused across
+///        messages stops allocating once it has grown to fit the largest one.
+///
+/// @tparam Tick `kc::tick`, `kc::compactTick` or `kc::fixedTick`
+///
+/// @param bytes  message
+/// @param size   size of the message
+/// @param buffer parsed ticks
+/// @param masks  fields to decode
+///
+/// @return size_t number of ticks parsed
+///
+template <class Tick>
+size_t parseInto(const char* bytes, size_t size, std::vector<Tick>& buffer,
+    const fieldMasks& masks = fieldMasks()) {
+    const frameView frame(bytes, size);
+    if (buffer.size() < frame.size()) { buffer.resize(frame.size()); };
+    size_t parsed = 0;
+    for (const packetView& packet : frame) {
+        Tick& tick = buffer[parsed++];
+        resetTick(tick);
+        parsePacket(packet, tick, masks);
+    };
+    return parsed;
+};
+
+/// @brief Store \a tick as the \a idx th tick of \a batch.
+inline void setBatchTick(
+    kc::tickBatch& batch, size_t idx, const kc::compactTick& tick) {
+    batch.instrumentToken[idx] = tick.instrumentToken;
+    batch.mode[idx] = tick.mode;
+    batch.isTradable[idx] = static_cast<uint8_t>(tick.isTradable);
+    batch.lastPrice[idx] = tick.lastPrice;
+    batch.lastTradedQuantity[idx] = tick.lastTradedQuantity;
+    batch.volumeTraded[idx] = tick.volumeTraded;
+    batch.averageTradePrice[idx] = tick.averageTradePrice;
+    batch.totalBuyQuantity[idx] = tick.totalBuyQuantity;
+    batch.totalSellQuantity[idx] = tick.totalSellQuantity;
+    batch.netChange[idx] = tick.netChange;
+    batch.timestamp[idx] = tick.timestamp;
+    batch.lastTradeTime[idx] = tick.lastTradeTime;
+    batch.open[idx] = tick.ohlc.open;
+    batch.high[idx] = tick.ohlc.high;
+    batch.low[idx] = tick.ohlc.low;
+    batch.close[idx] = tick.ohlc.close;
+    batch.oi[idx] = tick.oi;
+    batch.oiDayHigh[idx] = tick.oiDayHigh;
+    batch.oiDayLow[idx] = tick.oiDayLow;
+    static_assert(kc::tickBatch::DEPTH_ENTRIES_PER_SIDE ==
+                  kc::compactTick::DEPTH_ENTRIES_PER_SIDE);
+    for (size_t level = 0; level < kc::tickBatch::DEPTH_ENTRIES_PER_SIDE;
+         level++) {
+        const kc::depthWS& buy = tick.marketDepth.buy[level];
+        const kc::depthWS& sell = tick.marketDepth.sell[level];
+        batch.buyPrice[level][idx] = buy.price;
+        batch.buyQuantity[level][idx] = buy.quantity;
+        batch.buyOrders[level][idx] = buy.orders;
+        batch.sellPrice[level][idx] = sell.price;
+        batch.sellQuantity[level][idx] = sell.quantity;
+        batch.sellOrders[level][idx] = sell.orders;
+    };
+};
+
+///
+/// @brief Parse a binary message into \a batch, replacing its contents.
+///        Reusing \a batch across messages saves reallocating its columns.
+///
+/// @param bytes message
+/// @param size  size of the message
+/// @param batch parsed ticks
+/// @param masks fields to decode
+///
+inline void parse(const char* bytes, size_t size, kc::tickBatch& batch,
+    const fieldMasks& masks = fieldMasks()) {
+    const frameView frame(bytes, size);
+    batch.resize(frame.size());
+    size_t idx = 0;
+    for (const packetView& packet : frame) {
+        kc::compactTick tick;
+        parsePacket(packet, tick, masks);
+        setBatchTick(batch, idx++, tick);
+    };
+};
+
+///
+/// @brief Parse a binary message into \a ticks, replacing its contents.
+///        Reusing \a ticks across messages saves reallocating it.
+///
+/// @tparam Tick `kc::tick`, `kc::compactTick` or `kc::fixedTick`
+///
+/// @param bytes message
+/// @param size  size of the message
+/// @param ticks parsed ticks
+/// @param masks fields to decode
+///
+template <class Tick>
+void parse(const char* bytes, size_t size, std::vector<Tick>& ticks,
+    const fieldMasks& masks = fieldMasks()) {
+    const frameView frame(bytes, size);
+    ticks.clear();
+    ticks.reserve(frame.size());
+    for (const packetView& packet : frame) {
+        parsePacket(packet, ticks.emplace_back(), masks);
+    };
+};
+
+///
+/// @brief Parse a binary message into ticks.
+///
+/// @param bytes message
+/// @param size  size of the message
+///
+/// @return std::vector<kc::tick> parsed ticks
+///
+inline std::vector<kc::tick> parse(const char* bytes, size_t size) {
+    std::vector<kc::tick> ticks;
+    parse(bytes, size, ticks);
+    return ticks;
+};
+
+} // namespace kiteconnect::internal::binary
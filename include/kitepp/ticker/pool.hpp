@@ -0,0 +1,439 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/responses.hpp"
+#include "../userconstants.hpp"
+#include "binary.hpp"
+#include "ws.hpp"
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// @brief Spreads subscriptions across several `ticker` connections, each
+///        decoding ticks on its own I/O thread, behind a single set of
+///        callbacks.
+///
+/// Instruments are assigned to the connection with the lowest load, where
+/// each instrument weighs as much as the packets of its mode, e.g., a `full`
+/// instrument weighs 23 times an `ltp` one. When a connection is
+/// (re)established, instruments are moved to it from the busiest
+/// connections until loads are even. A moved instrument is subscribed on its
+/// new connection before it is unsubscribed from the old one, so its ticks
+/// may briefly be received twice.
+///
+/// \note Kite allows a limited number of connections per API key and
+///       `MAX_INSTRUMENTS_PER_CONNECTION` instruments per connection.
+///
+class tickerPool {
+
+  public:
+    static constexpr size_t MAX_INSTRUMENTS_PER_CONNECTION = 3000;
+
+    // callbacks, should be set before `start()`. They are called on the I/O
+    // thread of \a connection, i.e., concurrently for different connections.
+
+    /// @brief Called when \a connection is (re)established.
+    std::function<void(tickerPool* pool, size_t connection)> onConnect;
+
+    /// @brief Called with ticks received by \a connection.
+    std::function<void(tickerPool* pool, size_t connection,
+        const std::vector<kc::tick>& ticks)>
+        onTicks;
+
+    /// @brief Called with compact ticks received by \a connection.
+    std::function<void(tickerPool* pool, size_t connection,
+        const std::vector<kc::compactTick>& ticks)>
+        onCompactTicks;
+
+    /// @brief Called on order updates. Every connection receives them, only
+    ///        those of the first one are passed on.
+    std::function<void(tickerPool* pool, const kc::postback& postback)>
+        onOrderUpdate;
+
+    /// @brief Called when \a connection is closed with an error.
+    std::function<void(
+        tickerPool* pool, size_t connection, int code, const string& message)>
+        onError;
+
+    /// @brief Called when \a connection is closed.
+    std::function<void(
+        tickerPool* pool, size_t connection, int code, const string& message)>
+        onClose;
+
+    ///
+    /// @brief Construct a new pool. Connections always reconnect.
+    ///
+    /// @param Key               API key
+    /// @param Connections       number of connections
+    /// @param ConnectTimeout    connection timeout in seconds
+    /// @param MaxReconnectDelay maximum delay between reconnect attempts
+    /// @param MaxReconnectTries maximum number of reconnect attempts
+    ///
+    tickerPool(const string& Key, size_t Connections,
+        unsigned int ConnectTimeout = DEFAULT_CONNECT_TIMEOUT,
+        unsigned int MaxReconnectDelay = DEFAULT_MAX_RECONNECT_DELAY,
+        unsigned int MaxReconnectTries = DEFAULT_MAX_RECONNECT_TRIES) {
+        if (Connections == 0) {
+            throw kc::libException("a pool needs at least one connection");
+        };
+        connections.resize(Connections);
+        for (auto& Connection : connections) {
+            Connection.Ticker = std::make_unique<ticker>(Key, ConnectTimeout,
+                true, MaxReconnectDelay, MaxReconnectTries);
+        };
+    };
+
+    tickerPool(const tickerPool&) = delete;
+    tickerPool& operator=(const tickerPool&) = delete;
+
+    /// @brief Destroy the pool, stopping every connection.
+    ~tickerPool() { stop(); };
+
+    /// @brief Set the access token of every connection.
+    void setAccessToken(const string& token) {
+        for (auto& Connection : connections) {
+            Connection.Ticker->setAccessToken(token);
+        };
+    };
+
+    /// @brief Connect every connection & start their I/O threads.
+    void start() {
+        for (size_t idx = 0; idx < connections.size(); idx++) {
+            assignCallbacks(idx);
+            connections[idx].Ticker->connect();
+            connections[idx].Ticker->startIoThread(0);
+        };
+    };
+
+    /// @brief Stop every connection & wait for their I/O threads to exit.
+    void stop() {
+        for (auto& Connection : connections) { Connection.Ticker->stop(); };
+    };
+
+    ///
+    /// @brief Subscribe to \a instrumentTokens in \a mode, or change their
+    ///        mode if they are already subscribed. Can be called from any
+    ///        thread.
+    ///
+    /// @param instrumentTokens instrument tokens
+    /// @param mode             one of `MODE_LTP`, `MODE_QUOTE`, `MODE_FULL`
+    ///
+    void subscribe(const std::vector<int>& instrumentTokens,
+        const string& mode = MODE_QUOTE) {
+        const size_t weight = modeWeight(mode);
+        std::vector<bool> changed(connections.size(), false);
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            size_t added = 0;
+            size_t free = 0;
+            for (const int token : instrumentTokens) {
+                added += instrumentConnection.count(token) == 0 ? 1 : 0;
+            };
+            for (const auto& Connection : connections) {
+                free += MAX_INSTRUMENTS_PER_CONNECTION -
+                        Connection.assigned.size();
+            };
+            if (added > free) {
+                throw kc::libException("not enough room on the connections");
+            };
+
+            for (const int token : instrumentTokens) {
+                auto it = instrumentConnection.find(token);
+                if (it == instrumentConnection.end()) {
+                    it = instrumentConnection.emplace(token, leastLoaded())
+                             .first;
+                } else {
+                    connection& Connection = connections[it->second];
+                    Connection.load -=
+                        modeWeight(Connection.assigned.at(token));
+                };
+                connection& Connection = connections[it->second];
+                Connection.assigned[token] = mode;
+                Connection.load += weight;
+                changed[it->second] = true;
+            };
+        };
+        syncChanged(changed);
+    };
+
+    ///
+    /// @brief Unsubscribe from \a instrumentTokens. Can be called from any
+    ///        thread.
+    ///
+    void unsubscribe(const std::vector<int>& instrumentTokens) {
+        std::vector<bool> changed(connections.size(), false);
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            for (const int token : instrumentTokens) {
+                auto it = instrumentConnection.find(token);
+                if (it == instrumentConnection.end()) { continue; };
+                connection& Connection = connections[it->second];
+                Connection.load -= modeWeight(Connection.assigned.at(token));
+                Connection.assigned.erase(token);
+                changed[it->second] = true;
+                instrumentConnection.erase(it);
+            };
+        };
+        syncChanged(changed);
+    };
+
+    ///
+    /// @brief Move instruments from the busiest connections to \a target
+    ///        until loads are even. Called whenever a connection is
+    ///        (re)established.
+    ///
+    void rebalance(size_t target) {
+        std::vector<size_t> donors;
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            connection& Target = connections.at(target);
+            while (Target.assigned.size() < MAX_INSTRUMENTS_PER_CONNECTION) {
+                size_t donor = target;
+                for (size_t idx = 0; idx < connections.size(); idx++) {
+                    if (idx != target &&
+                        (donor == target ||
+                            connections[idx].load > connections[donor].load)) {
+                        donor = idx;
+                    };
+                };
+                if (donor == target ||
+                    connections[donor].load <= Target.load) {
+                    break;
+                };
+
+                // moving an instrument must narrow the gap
+                connection& Donor = connections[donor];
+                const size_t gap = Donor.load - Target.load;
+                auto it = Donor.assigned.begin();
+                while (it != Donor.assigned.end() &&
+                       modeWeight(it->second) >= gap) {
+                    it++;
+                };
+                if (it == Donor.assigned.end()) { break; };
+
+                const size_t weight = modeWeight(it->second);
+                instrumentConnection[it->first] = target;
+                Target.assigned.emplace(it->first, it->second);
+                Target.load += weight;
+                Donor.load -= weight;
+                Donor.assigned.erase(it);
+                if (std::find(donors.begin(), donors.end(), donor) ==
+                    donors.end()) {
+                    donors.push_back(donor);
+                };
+            };
+        };
+        if (donors.empty()) { return; };
+
+        // subscribe on the target before unsubscribing from the donors
+        connections[target].Ticker->post([this, target, donors](ticker*) {
+            sync(target);
+            for (const size_t donor : donors) { post(donor); };
+        });
+    };
+
+    /// @brief Get the number of connections.
+    size_t size() const { return connections.size(); };
+
+    ///
+    /// @brief Get the connection \a instrumentToken is assigned to.
+    ///
+    /// @return std::optional<size_t> connection, empty if \a instrumentToken
+    ///         isn't subscribed
+    ///
+    std::optional<size_t> getConnection(int instrumentToken) const {
+        const std::lock_guard<std::mutex> lock(mutex);
+        auto it = instrumentConnection.find(instrumentToken);
+        if (it == instrumentConnection.end()) { return std::nullopt; };
+        return it->second;
+    };
+
+    /// @brief Get the number of instruments assigned to \a connection.
+    size_t getInstrumentCount(size_t connection) const {
+        const std::lock_guard<std::mutex> lock(mutex);
+        return connections.at(connection).assigned.size();
+    };
+
+    /// @brief Get the sum of weights of instruments assigned to \a connection.
+    size_t getLoad(size_t connection) const {
+        const std::lock_guard<std::mutex> lock(mutex);
+        return connections.at(connection).load;
+    };
+
+    /// @brief Get the `ticker` of \a connection.
+    ticker& getTicker(size_t connection) {
+        return *connections.at(connection).Ticker;
+    };
+
+  private:
+    static constexpr unsigned int DEFAULT_CONNECT_TIMEOUT = 5;      // s
+    static constexpr unsigned int DEFAULT_MAX_RECONNECT_DELAY = 60; // s
+    static constexpr unsigned int DEFAULT_MAX_RECONNECT_TRIES = 30;
+
+    struct connection {
+        std::unique_ptr<ticker> Ticker;
+        // instruments the connection should be subscribed to & their modes
+        std::unordered_map<int, string> assigned;
+        // instruments sent to the connection, mirrors what `ticker`
+        // resubscribes to after reconnecting
+        std::unordered_map<int, string> applied;
+        size_t load = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<connection> connections;
+    std::unordered_map<int, size_t> instrumentConnection;
+
+    // weight ~ bytes per tick
+    static size_t modeWeight(const string& mode) {
+        if (mode == MODE_LTP) { return internal::binary::layout::ltp::SIZE; };
+        if (mode == MODE_QUOTE) {
+            return internal::binary::layout::quote::SIZE;
+        };
+        if (mode == MODE_FULL) { return internal::binary::layout::full::SIZE; };
+        throw kc::libException("invalid mode: " + mode);
+    };
+
+    size_t leastLoaded() const {
+        size_t least = connections.size();
+        for (size_t idx = 0; idx < connections.size(); idx++) {
+            if (connections[idx].assigned.size() >=
+                MAX_INSTRUMENTS_PER_CONNECTION) {
+                continue;
+            };
+            if (least == connections.size() ||
+                connections[idx].load < connections[least].load) {
+                least = idx;
+            };
+        };
+        return least;
+    };
+
+    void syncChanged(const std::vector<bool>& changed) {
+        for (size_t idx = 0; idx < changed.size(); idx++) {
+            if (changed[idx]) { post(idx); };
+        };
+    };
+
+    // ticker is only safe to use from its I/O thread
+    void post(size_t idx) {
+        connections[idx].Ticker->post([this, idx](ticker*) { sync(idx); });
+    };
+
+    // sends the difference between what \a idx should be & is subscribed to
+    void sync(size_t idx) {
+        ticker& Ticker = *connections[idx].Ticker;
+        // synced once connected
+        if (!Ticker.isConnected()) { return; };
+
+        std::vector<int> removed;
+        std::unordered_map<string, std::vector<int>> modes;
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            connection& Connection = connections[idx];
+            for (const auto& [token, mode] : Connection.applied) {
+                if (Connection.assigned.count(token) == 0) {
+                    removed.push_back(token);
+                };
+            };
+            for (const auto& [token, mode] : Connection.assigned) {
+                auto it = Connection.applied.find(token);
+                if (it == Connection.applied.end() || it->second != mode) {
+                    modes[mode].push_back(token);
+                };
+            };
+            for (const int token : removed) {
+                Connection.applied.erase(token);
+            };
+            for (const auto& [mode, tokens] : modes) {
+                for (const int token : tokens) {
+                    Connection.applied[token] = mode;
+                };
+            };
+        };
+
+        if (!removed.empty()) { Ticker.unsubscribe(removed); };
+        for (const auto& [mode, tokens] : modes) {
+            Ticker.subscribe(tokens);
+            Ticker.setMode(mode, tokens);
+        };
+    };
+
+    void assignCallbacks(size_t idx) {
+        ticker& Ticker = *connections[idx].Ticker;
+        Ticker.onConnect = [this, idx](ticker*) {
+            // on the connection's I/O thread already
+            sync(idx);
+            rebalance(idx);
+            if (onConnect) { onConnect(this, idx); };
+        };
+        if (onTicks) {
+            Ticker.onTicks = [this, idx](
+                                 ticker*, const std::vector<kc::tick>& ticks) {
+                onTicks(this, idx, ticks);
+            };
+        };
+        if (onCompactTicks) {
+            Ticker.onCompactTicks =
+                [this, idx](
+                    ticker*, const std::vector<kc::compactTick>& ticks) {
+                    onCompactTicks(this, idx, ticks);
+                };
+        };
+        if (onOrderUpdate && idx == 0) {
+            Ticker.onOrderUpdate = [this](
+                                       ticker*, const kc::postback& postback) {
+                onOrderUpdate(this, postback);
+            };
+        };
+        Ticker.onError = [this, idx](
+                             ticker*, int code, const string& message) {
+            if (onError) { onError(this, idx, code, message); };
+        };
+        Ticker.onClose = [this, idx](
+                             ticker*, int code, const string& message) {
+            if (onClose) { onClose(this, idx, code, message); };
+        };
+    };
+};
+
+} // namespace kiteconnect
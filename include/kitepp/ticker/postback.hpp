@@ -0,0 +1,336 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+
+#include "rapidjson/include/rapidjson/rapidjson.h"
+#include "rapidjson/include/rapidjson/reader.h"
+
+namespace kiteconnect::internal {
+
+using std::string;
+namespace kc = kiteconnect;
+namespace rj = rapidjson;
+
+namespace postbackKeys {
+
+/// @brief A member of an order update & the `postback` field it goes to.
+struct field {
+    std::string_view key;
+    string kc::postback::*text = nullptr;
+    int kc::postback::*integer = nullptr;
+    double kc::postback::*number = nullptr;
+};
+
+constexpr field text(std::string_view key, string kc::postback::*member) {
+    return { key, member, nullptr, nullptr };
+};
+
+constexpr field integer(std::string_view key, int kc::postback::*member) {
+    return { key, nullptr, member, nullptr };
+};
+
+constexpr field number(std::string_view key, double kc::postback::*member) {
+    return { key, nullptr, nullptr, member };
+};
+
+constexpr std::array<field, 21> FIELDS = {
+    text("order_id", &kc::postback::orderId),
+    text("exchange_order_id", &kc::postback::exchangeOrderId),
+    text("placed_by", &kc::postback::placedBy),
+    text("status", &kc::postback::status),
+    text("status_message", &kc::postback::statusMessage),
+    text("tradingsymbol", &kc::postback::tradingSymbol),
+    text("exchange", &kc::postback::exchange),
+    text("order_type", &kc::postback::orderType),
+    text("transaction_type", &kc::postback::transactionType),
+    text("validity", &kc::postback::validity),
+    text("product", &kc::postback::product),
+    number("average_price", &kc::postback::averagePrice),
+    number("price", &kc::postback::price),
+    integer("quantity", &kc::postback::quantity),
+    integer("filled_quantity", &kc::postback::filledQuantity),
+    integer("unfilled_quantity", &kc::postback::unfilledQuantity),
+    number("trigger_price", &kc::postback::triggerPrice),
+    text("user_id", &kc::postback::userId),
+    text("order_timestamp", &kc::postback::orderTimestamp),
+    text("exchange_timestamp", &kc::postback::exchangeTimestamp),
+    text("checksum", &kc::postback::checksum),
+};
+
+constexpr size_t TABLE_SIZE = 64;
+constexpr uint8_t EMPTY = std::numeric_limits<uint8_t>::max();
+
+///
+/// @brief Hash that maps each key in `FIELDS` to a slot of its own, checked
+///        below. Other keys are told apart by comparing them with the key
+///        in their slot.
+///
+constexpr size_t hash(std::string_view key) {
+    if (key.size() < 2) { return 0; };
+    return (key.size() + (static_cast<size_t>(key[0]) << 3U) +
+               static_cast<size_t>(key[key.size() - 2])) &
+           (TABLE_SIZE - 1);
+};
+
+constexpr std::array<uint8_t, TABLE_SIZE> makeTable() {
+    std::array<uint8_t, TABLE_SIZE> table {};
+    for (auto& slot : table) { slot = EMPTY; };
+    for (size_t idx = 0; idx < FIELDS.size(); idx++) {
+        table[hash(FIELDS[idx].key)] = static_cast<uint8_t>(idx);
+    };
+    return table;
+};
+
+constexpr std::array<uint8_t, TABLE_SIZE> TABLE = makeTable();
+
+constexpr bool isPerfect() {
+    for (size_t idx = 0; idx < FIELDS.size(); idx++) {
+        if (TABLE[hash(FIELDS[idx].key)] != idx) { return false; };
+    };
+    return true;
+};
+static_assert(isPerfect(), "postback keys should hash to distinct slots");
+
+/// @brief Get the field of \a key, `nullptr` if it isn't one.
+inline const field* find(std::string_view key) {
+    const uint8_t idx = TABLE[hash(key)];
+    if (idx == EMPTY || FIELDS[idx].key != key) { return nullptr; };
+    return &FIELDS[idx];
+};
+
+} // namespace postbackKeys
+
+///
+/// @brief Parses websocket text messages, e.g.,
+///        `{"type":"order","data":{...}}`, with a SAX parser, writing order
+///        updates straight into a reused `kc::postback`.
+///
+/// The message is copied into a buffer that is reused for every message and
+/// parsed in place, so strings aren't copied again until assigned to their
+/// field. Members are looked up with a perfect hash. Once the buffer & the
+/// postback's strings have grown to fit the largest message, parsing doesn't
+/// allocate. Fields are set as `kc::postback::parse()` sets them.
+///
+class textMessageParser {
+
+  public:
+    ///
+    /// @brief Parse \a message. Results are valid until the next call.
+    ///
+    /// @throws kc::libException if \a message isn't a JSON object or a
+    ///         field of an order update has an unexpected type
+    ///
+    void parse(const char* message, size_t length) {
+        buffer.assign(message, message + length);
+        buffer.push_back('\0');
+        reset();
+        rj::InsituStringStream stream(buffer.data());
+        rj::Reader reader;
+        handler Handler { *this };
+        if (reader.Parse<rj::kParseInsituFlag>(stream, Handler).IsError() ||
+            !isObject) {
+            throw kc::libException("Expected a JSON object");
+        };
+    };
+
+    /// @brief Get the `type` of the message, empty if it had none.
+    const string& getType() const { return type; };
+
+    /// @brief Get the order update sent as `data`.
+    const kc::postback& getPostback() const {
+        if (!hasPostback) { throw kc::libException("invalid body"); };
+        return Postback;
+    };
+
+    /// @brief Get the string sent as `data`, e.g., of an error.
+    const string& getData() const {
+        if (!hasData) { throw kc::libException("invalid body"); };
+        return data;
+    };
+
+  private:
+    std::vector<char> buffer;
+    string type;
+    string data;
+    kc::postback Postback;
+    bool isObject = false;
+    bool hasPostback = false;
+    bool hasData = false;
+
+    // keeps allocated capacity of the strings
+    void reset() {
+        type.clear();
+        data.clear();
+        isObject = false;
+        hasPostback = false;
+        hasData = false;
+        Postback.quantity = 0;
+        Postback.filledQuantity = 0;
+        Postback.unfilledQuantity = 0;
+        Postback.averagePrice = 0;
+        Postback.price = 0;
+        Postback.triggerPrice = 0;
+        for (const auto& field : postbackKeys::FIELDS) {
+            if (field.text != nullptr) { (Postback.*field.text).clear(); };
+        };
+    };
+
+    struct handler : rj::BaseReaderHandler<rj::UTF8<>, handler> {
+        enum class KEY : uint8_t
+        {
+            NONE,
+            TYPE,
+            DATA,
+        };
+
+        textMessageParser& parser;
+        unsigned int depth = 0;
+        // top level member being parsed
+        KEY key = KEY::NONE;
+        // member of the order update being parsed
+        const postbackKeys::field* field = nullptr;
+        std::string_view fieldKey;
+
+        explicit handler(textMessageParser& Parser) : parser(Parser) {};
+
+        bool StartObject() {
+            depth++;
+            if (depth == 1) { parser.isObject = true; };
+            if (depth == 2 && key == KEY::DATA) { parser.hasPostback = true; };
+            field = nullptr;
+            return true;
+        };
+
+        bool EndObject(rj::SizeType /*memberCount*/) {
+            depth--;
+            return true;
+        };
+
+        bool StartArray() {
+            depth++;
+            field = nullptr;
+            return true;
+        };
+
+        bool EndArray(rj::SizeType /*elementCount*/) {
+            depth--;
+            return true;
+        };
+
+        bool Key(const char* str, rj::SizeType length, bool /*copy*/) {
+            const std::string_view name(str, length);
+            if (depth == 1) {
+                key = (name == "type") ? KEY::TYPE :
+                      (name == "data") ? KEY::DATA :
+                                         KEY::NONE;
+            } else if (depth == 2 && key == KEY::DATA) {
+                field = postbackKeys::find(name);
+                fieldKey = name;
+            };
+            return true;
+        };
+
+        bool String(const char* str, rj::SizeType length, bool /*copy*/) {
+            if (depth == 1) {
+                if (key == KEY::TYPE) { parser.type.assign(str, length); };
+                if (key == KEY::DATA) {
+                    parser.data.assign(str, length);
+                    parser.hasData = true;
+                };
+                return true;
+            };
+            if (!isField()) { return true; };
+            if (field->text == nullptr) { mismatch(); };
+            (parser.Postback.*field->text).assign(str, length);
+            return true;
+        };
+
+        bool Null() {
+            // null strings are read as empty ones
+            if (isField() && field->text == nullptr) { mismatch(); };
+            return true;
+        };
+
+        bool Int(int value) { return setNumber(value, true); };
+
+        bool Uint(unsigned int value) {
+            return setNumber(value,
+                value <= static_cast<unsigned int>(
+                             std::numeric_limits<int>::max()));
+        };
+
+        bool Int64(int64_t value) {
+            return setNumber(static_cast<double>(value), false);
+        };
+
+        bool Uint64(uint64_t value) {
+            return setNumber(static_cast<double>(value), false);
+        };
+
+        bool Double(double value) { return setNumber(value, false); };
+
+        bool Default() {
+            if (isField()) { mismatch(); };
+            return true;
+        };
+
+      private:
+        bool isField() const { return depth == 2 && field != nullptr; };
+
+        // whole numbers that fit in an `int` can go to `int` & `double`
+        // fields, others only to `double` fields
+        template <class Number>
+        bool setNumber(Number value, bool fitsInt) {
+            if (!isField()) { return true; };
+            if (field->number != nullptr) {
+                parser.Postback.*field->number = static_cast<double>(value);
+            } else if (field->integer != nullptr && fitsInt) {
+                parser.Postback.*field->integer = static_cast<int>(value);
+            } else {
+                mismatch();
+            };
+            return true;
+        };
+
+        [[noreturn]] void mismatch() const {
+            throw kc::libException(
+                "unexpected type of " + string(fieldKey));
+        };
+    };
+};
+
+} // namespace kiteconnect::internal
@@ -0,0 +1,400 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../span.hpp"
+#include "../userconstants.hpp"
+#include "subscriptions.hpp"
+#include "ws.hpp"
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+/// Which leg of a `redundantTicker` delivered ticks first.
+struct redundancyStats {
+    /// number of ticks passed on from each leg
+    std::array<uint64_t, 2> won {};
+    /// number of ticks dropped because the other leg delivered them first
+    uint64_t duplicates = 0;
+    /// number of ticks passed on without deduplication because the
+    /// instrument table was full or their instrument isn't subscribed
+    uint64_t untracked = 0;
+};
+
+///
+/// @brief Keeps two connections subscribed to the same instruments and
+///        passes on whichever copy of a tick arrives first, so that a
+///        dropped connection doesn't leave a gap while it reconnects.
+///
+/// A tick is a duplicate unless its (exchange timestamp, volume) is newer
+/// than that of the last tick passed on for its instrument. Ticks carrying
+/// neither, i.e., `ltp` mode & index quotes, are passed on from the first
+/// connected leg only.
+///
+/// Only subscribed instruments are deduplicated. The slot of an instrument is
+/// freed when it's unsubscribed & reused once neither leg can still be
+/// deduplicating a tick of it.
+///
+class redundantTicker {
+
+  public:
+    static constexpr size_t LEGS = 2;
+
+    // callbacks, should be set before `start()`. They are called on the I/O
+    // thread of \a leg, i.e., concurrently for different legs.
+
+    /// @brief Called when \a leg is (re)established.
+    std::function<void(redundantTicker* ws, size_t leg)> onConnect;
+
+    /// @brief Called with ticks \a leg delivered first.
+    std::function<void(redundantTicker* ws, size_t leg,
+        kc::span<const kc::compactTick> ticks)>
+        onTicks;
+
+    /// @brief Called when \a leg is closed.
+    std::function<void(
+        redundantTicker* ws, size_t leg, int code, const string& message)>
+        onClose;
+
+    ///
+    /// @brief Construct a new redundant ticker. Legs always reconnect.
+    ///
+    /// @param Key               API key
+    /// @param MaxInstruments    maximum number of instruments subscribed at
+    ///                          a time that are deduplicated
+    /// @param ConnectTimeout    connection timeout in seconds
+    /// @param MaxReconnectDelay maximum delay between reconnect attempts
+    /// @param MaxReconnectTries maximum number of reconnect attempts
+    ///
+    redundantTicker(const string& Key, size_t MaxInstruments,
+        unsigned int ConnectTimeout = DEFAULT_CONNECT_TIMEOUT,
+        unsigned int MaxReconnectDelay = DEFAULT_MAX_RECONNECT_DELAY,
+        unsigned int MaxReconnectTries = DEFAULT_MAX_RECONNECT_TRIES) {
+        if (MaxInstruments == 0) {
+            throw kc::libException("max instruments can't be 0");
+        };
+        while (tableSize < 2 * MaxInstruments) { tableSize <<= 1U; };
+        tokens = std::make_unique<std::atomic<int32_t>[]>(tableSize);
+        lastKeys = std::make_unique<std::atomic<uint64_t>[]>(tableSize);
+        retiredAt.resize(tableSize, 0);
+        for (size_t idx = 0; idx < tableSize; idx++) {
+            tokens[idx].store(EMPTY, std::memory_order_relaxed);
+            lastKeys[idx].store(0, std::memory_order_relaxed);
+        };
+        for (auto& Leg : legs) {
+            Leg.Ticker = std::make_unique<ticker>(Key, ConnectTimeout, true,
+                MaxReconnectDelay, MaxReconnectTries);
+        };
+    };
+
+    redundantTicker(const redundantTicker&) = delete;
+    redundantTicker& operator=(const redundantTicker&) = delete;
+
+    /// @brief Destroy the object, stopping both legs.
+    ~redundantTicker() { stop(); };
+
+    /// @brief Set the access token of both legs.
+    void setAccessToken(const string& token) {
+        for (auto& Leg : legs) { Leg.Ticker->setAccessToken(token); };
+    };
+
+    /// @brief Connect both legs & start their I/O threads.
+    void start() {
+        for (size_t idx = 0; idx < LEGS; idx++) {
+            assignCallbacks(idx);
+            legs[idx].Ticker->connect();
+            legs[idx].Ticker->startIoThread(0);
+        };
+    };
+
+    /// @brief Stop both legs & wait for their I/O threads to exit.
+    void stop() {
+        for (auto& Leg : legs) { Leg.Ticker->stop(); };
+    };
+
+    ///
+    /// @brief Subscribe both legs to \a instrumentTokens in \a mode. Can be
+    ///        called from any thread.
+    ///
+    /// @throws kc::libException if \a mode isn't one of `MODE_LTP`,
+    ///         `MODE_QUOTE` & `MODE_FULL`
+    ///
+    void subscribe(const std::vector<int>& instrumentTokens,
+        const string& mode = MODE_QUOTE) {
+        // the legs would throw on their I/O threads, on every reconnect
+        internal::toTickMode(mode);
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            for (const int token : instrumentTokens) {
+                subscriptions[token] = mode;
+            };
+        };
+        for (auto& Leg : legs) {
+            Leg.Ticker->post([instrumentTokens, mode](ticker* Ticker) {
+                // legs (re)connecting subscribe to everything anyway
+                if (!Ticker->isConnected()) { return; };
+                Ticker->subscribe(instrumentTokens);
+                Ticker->setMode(mode, instrumentTokens);
+            });
+        };
+    };
+
+    /// @brief Unsubscribe both legs from \a instrumentTokens.
+    void unsubscribe(const std::vector<int>& instrumentTokens) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            for (const int token : instrumentTokens) {
+                if (subscriptions.erase(token) != 0) { release(token); };
+            };
+            // legs entering `deliver()` from now on can't find the released
+            // slots
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+        };
+        for (auto& Leg : legs) {
+            Leg.Ticker->post([instrumentTokens](ticker* Ticker) {
+                if (!Ticker->isConnected()) { return; };
+                Ticker->unsubscribe(instrumentTokens);
+            });
+        };
+    };
+
+    ///
+    /// @brief Filter out the ticks of \a ticks that were already passed on &
+    ///        call `onTicks` with the rest. Called by each leg with the ticks
+    ///        it receives.
+    ///
+    void deliver(size_t leg, kc::span<const kc::compactTick> ticks) {
+        std::vector<kc::compactTick>& accepted = legs.at(leg).accepted;
+        accepted.clear();
+        // slots released before this epoch aren't reused until we're done
+        legs[leg].activeEpoch.store(
+            epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (const kc::compactTick& tick : ticks) {
+            if (isFirst(leg, tick)) { accepted.push_back(tick); };
+        };
+        legs[leg].activeEpoch.store(IDLE, std::memory_order_release);
+        won[leg].fetch_add(accepted.size(), std::memory_order_relaxed);
+        duplicates.fetch_add(
+            ticks.size() - accepted.size(), std::memory_order_relaxed);
+        if (!accepted.empty() && onTicks) {
+            onTicks(this, leg, kc::span<const kc::compactTick>(accepted));
+        };
+    };
+
+    /// @brief Get the number of ticks each leg won & of duplicates dropped.
+    redundancyStats getStats() const {
+        redundancyStats Stats;
+        for (size_t idx = 0; idx < LEGS; idx++) {
+            Stats.won[idx] = won[idx].load(std::memory_order_relaxed);
+        };
+        Stats.duplicates = duplicates.load(std::memory_order_relaxed);
+        Stats.untracked = untracked.load(std::memory_order_relaxed);
+        return Stats;
+    };
+
+    /// @brief Get the `ticker` of \a leg.
+    ticker& getLeg(size_t leg) { return *legs.at(leg).Ticker; };
+
+  private:
+    static constexpr unsigned int DEFAULT_CONNECT_TIMEOUT = 5;      // s
+    static constexpr unsigned int DEFAULT_MAX_RECONNECT_DELAY = 60; // s
+    static constexpr unsigned int DEFAULT_MAX_RECONNECT_TRIES = 30;
+    static constexpr int32_t EMPTY = std::numeric_limits<int32_t>::min();
+    // slot of an unsubscribed instrument, skipped by lookups
+    static constexpr int32_t FREED = EMPTY + 1;
+    static constexpr uint64_t IDLE = 0;
+
+    struct leg {
+        std::unique_ptr<ticker> Ticker;
+        std::atomic<bool> connected { false };
+        // epoch the leg entered `deliver()` in, `IDLE` outside it
+        std::atomic<uint64_t> activeEpoch { IDLE };
+        // only used on the leg's I/O thread
+        std::vector<kc::compactTick> accepted;
+    };
+
+    std::array<leg, LEGS> legs;
+    std::mutex mutex;
+    std::unordered_map<int, string> subscriptions;
+    // instrument token -> key of the last tick passed on, open addressing
+    size_t tableSize = 1;
+    std::unique_ptr<std::atomic<int32_t>[]> tokens;
+    std::unique_ptr<std::atomic<uint64_t>[]> lastKeys;
+    // epoch each freed slot was released in, guarded by `mutex`
+    std::vector<uint64_t> retiredAt;
+    std::atomic<uint64_t> epoch { IDLE + 1 };
+    std::array<std::atomic<uint64_t>, LEGS> won {};
+    std::atomic<uint64_t> duplicates { 0 };
+    std::atomic<uint64_t> untracked { 0 };
+
+    // exchange timestamp & volume, compared as one number. 0 if neither is
+    // present.
+    static uint64_t tickKey(const kc::compactTick& tick) {
+        const auto timestamp =
+            static_cast<uint32_t>(std::max<int32_t>(tick.timestamp, 0));
+        const auto volume =
+            static_cast<uint32_t>(std::max<int32_t>(tick.volumeTraded, 0));
+        return (static_cast<uint64_t>(timestamp) << 32U) | volume;
+    };
+
+    bool isFirst(size_t leg, const kc::compactTick& tick) {
+        const uint64_t key = tickKey(tick);
+        if (key == 0) {
+            const bool firstConnected =
+                legs[0].connected.load(std::memory_order_relaxed);
+            return leg == (firstConnected ? 0 : 1);
+        };
+
+        std::atomic<uint64_t>* last = lastKey(tick.instrumentToken);
+        if (last == nullptr) {
+            untracked.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        };
+        uint64_t previous = last->load(std::memory_order_relaxed);
+        while (key > previous) {
+            if (last->compare_exchange_weak(
+                    previous, key, std::memory_order_relaxed)) {
+                return true;
+            };
+        };
+        return false;
+    };
+
+    size_t home(int32_t instrumentToken) const {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        const uint64_t hash = static_cast<uint32_t>(instrumentToken) *
+                              0x9e3779b97f4a7c15ULL;
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        return static_cast<size_t>(hash >> 32U) & (tableSize - 1);
+    };
+
+    // index of the slot of \a instrumentToken, `tableSize` if it has none
+    size_t find(int32_t instrumentToken) const {
+        size_t idx = home(instrumentToken);
+        for (size_t probes = 0; probes < tableSize; probes++) {
+            const int32_t current = tokens[idx].load(std::memory_order_acquire);
+            if (current == instrumentToken) { return idx; };
+            if (current == EMPTY) { break; };
+            idx = (idx + 1) & (tableSize - 1);
+        };
+        return tableSize;
+    };
+
+    // whether no leg can still hold a slot released in \a retired
+    bool isReusable(uint64_t retired) const {
+        for (const auto& Leg : legs) {
+            const uint64_t active =
+                Leg.activeEpoch.load(std::memory_order_seq_cst);
+            if (active != IDLE && active <= retired) { return false; };
+        };
+        return true;
+    };
+
+    // claims a slot for subscribed instruments, nullptr if the table is full
+    // or the instrument isn't subscribed. Slots are only claimed & released
+    // under `mutex`, so a token never has two.
+    std::atomic<uint64_t>* lastKey(int32_t instrumentToken) {
+        size_t found = find(instrumentToken);
+        if (found != tableSize) { return &lastKeys[found]; };
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        found = find(instrumentToken);
+        if (found != tableSize) { return &lastKeys[found]; };
+        if (subscriptions.count(instrumentToken) == 0) { return nullptr; };
+        size_t idx = home(instrumentToken);
+        for (size_t probes = 0; probes < tableSize; probes++) {
+            const int32_t current = tokens[idx].load(std::memory_order_relaxed);
+            if (current == EMPTY ||
+                (current == FREED && isReusable(retiredAt[idx]))) {
+                lastKeys[idx].store(0, std::memory_order_relaxed);
+                tokens[idx].store(instrumentToken, std::memory_order_release);
+                return &lastKeys[idx];
+            };
+            idx = (idx + 1) & (tableSize - 1);
+        };
+        return nullptr;
+    };
+
+    // frees the slot of \a instrumentToken, called under `mutex`
+    void release(int32_t instrumentToken) {
+        const size_t idx = find(instrumentToken);
+        if (idx == tableSize) { return; };
+        tokens[idx].store(FREED, std::memory_order_seq_cst);
+        retiredAt[idx] = epoch.load(std::memory_order_seq_cst);
+    };
+
+    void resubscribe(ticker& Ticker) {
+        std::unordered_map<string, std::vector<int>> modes;
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& [token, mode] : subscriptions) {
+                modes[mode].push_back(token);
+            };
+        };
+        for (const auto& [mode, instrumentTokens] : modes) {
+            Ticker.subscribe(instrumentTokens);
+            Ticker.setMode(mode, instrumentTokens);
+        };
+    };
+
+    void assignCallbacks(size_t idx) {
+        ticker& Ticker = *legs[idx].Ticker;
+        Ticker.onConnect = [this, idx](ticker* Leg) {
+            legs[idx].connected.store(true, std::memory_order_relaxed);
+            resubscribe(*Leg);
+            if (onConnect) { onConnect(this, idx); };
+        };
+        Ticker.onCompactTicks =
+            [this, idx](ticker*, const std::vector<kc::compactTick>& ticks) {
+                deliver(idx, kc::span<const kc::compactTick>(ticks));
+            };
+        Ticker.onClose = [this, idx](
+                             ticker*, int code, const string& message) {
+            legs[idx].connected.store(false, std::memory_order_relaxed);
+            if (onClose) { onClose(this, idx, code, message); };
+        };
+    };
+};
+
+} // namespace kiteconnect
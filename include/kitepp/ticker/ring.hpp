@@ -0,0 +1,216 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "../exceptions.hpp"
+#include "../span.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+/// Snapshot of the state of a queue of ticks.
+struct queueStats {
+    /// maximum number of elements the queue can hold
+    size_t capacity = 0;
+    /// number of elements waiting to be popped
+    size_t depth = 0;
+    /// largest depth seen so far
+    size_t highWaterMark = 0;
+    /// number of elements pushed
+    uint64_t pushed = 0;
+    /// number of elements dropped because the queue was full
+    uint64_t dropped = 0;
+};
+
+///
+/// @brief Bounded, lock-free queue with a single producer and a single
+///        consumer thread. Neither side ever blocks; pushing to a full queue
+///        drops the element and counts it in `queueStats::dropped`.
+///
+/// @tparam T trivially copyable element type, e.g., `kc::compactTick`
+///
+template <class T>
+class spscRing {
+    static_assert(std::is_trivially_copyable_v<T>,
+        "elements are copied in and out of the ring");
+
+  public:
+    ///
+    /// @brief Construct a new ring.
+    ///
+    /// @param Capacity minimum number of elements the ring should hold,
+    ///                 rounded up to a power of two
+    ///
+    explicit spscRing(size_t Capacity) {
+        if (Capacity == 0) {
+            throw kc::libException("capacity of a ring can't be 0");
+        };
+        capacity = 1;
+        while (capacity < Capacity) { capacity <<= 1U; };
+        mask = capacity - 1;
+        slots = std::make_unique<T[]>(capacity);
+    };
+
+    spscRing(const spscRing&) = delete;
+    spscRing& operator=(const spscRing&) = delete;
+
+    ///
+    /// @brief Push \a value. Should only be called by the producer.
+    ///
+    /// @return bool `false` if the ring was full and \a value was dropped
+    ///
+    bool tryPush(const T& value) {
+        return tryPush(kc::span<const T>(&value, 1)) == 1;
+    };
+
+    ///
+    /// @brief Push as many of \a values as fit. The rest are dropped. Should
+    ///        only be called by the producer.
+    ///
+    /// @return size_t number of elements pushed
+    ///
+    size_t tryPush(kc::span<const T> values) {
+        const size_t tail = producer.tail.load(std::memory_order_relaxed);
+        size_t free = capacity - (tail - producer.cachedHead);
+        if (free < values.size()) {
+            producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+            free = capacity - (tail - producer.cachedHead);
+        };
+        const size_t count = std::min(free, values.size());
+        for (size_t i = 0; i < count; i++) {
+            slots[(tail + i) & mask] = values[i];
+        };
+        producer.tail.store(tail + count, std::memory_order_release);
+
+        producer.pushed.store(
+            producer.pushed.load(std::memory_order_relaxed) + count,
+            std::memory_order_relaxed);
+        if (count < values.size()) {
+            producer.dropped.store(
+                producer.dropped.load(std::memory_order_relaxed) +
+                    (values.size() - count),
+                std::memory_order_relaxed);
+        };
+        return count;
+    };
+
+    ///
+    /// @brief Pop the oldest element into \a value. Should only be called by
+    ///        the consumer.
+    ///
+    /// @return bool `false` if the ring was empty
+    ///
+    bool tryPop(T& value) { return tryPop(&value, 1) == 1; };
+
+    ///
+    /// @brief Pop up to \a maxCount of the oldest elements into \a values.
+    ///        Should only be called by the consumer.
+    ///
+    /// @return size_t number of elements popped
+    ///
+    size_t tryPop(T* values, size_t maxCount) {
+        const size_t head = consumer.head.load(std::memory_order_relaxed);
+        size_t available = consumer.cachedTail - head;
+        if (available < maxCount) {
+            consumer.cachedTail =
+                producer.tail.load(std::memory_order_acquire);
+            available = consumer.cachedTail - head;
+        };
+        // the depth seen here is exact when the tail was just loaded & a
+        // lower bound otherwise, so the mark costs the producer nothing
+        if (available >
+            consumer.highWaterMark.load(std::memory_order_relaxed)) {
+            consumer.highWaterMark.store(available, std::memory_order_relaxed);
+        };
+        const size_t count = std::min(available, maxCount);
+        for (size_t i = 0; i < count; i++) {
+            values[i] = slots[(head + i) & mask];
+        };
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    };
+
+    /// @brief Get the number of elements waiting to be popped.
+    size_t size() const {
+        const size_t head = consumer.head.load(std::memory_order_acquire);
+        const size_t tail = producer.tail.load(std::memory_order_acquire);
+        return tail - head;
+    };
+
+    /// @brief Check whether the ring is empty.
+    bool empty() const { return size() == 0; };
+
+    /// @brief Get the maximum number of elements the ring can hold.
+    size_t getCapacity() const { return capacity; };
+
+    /// @brief Get a snapshot of the ring's metrics. Can be called by any
+    ///        thread.
+    queueStats stats() const {
+        queueStats Stats;
+        Stats.capacity = capacity;
+        Stats.depth = size();
+        // a stalled consumer doesn't sample the depth
+        Stats.highWaterMark = std::max(Stats.depth,
+            consumer.highWaterMark.load(std::memory_order_relaxed));
+        Stats.pushed = producer.pushed.load(std::memory_order_relaxed);
+        Stats.dropped = producer.dropped.load(std::memory_order_relaxed);
+        return Stats;
+    };
+
+  private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // written by the producer only, kept off the consumer's cache line
+    struct alignas(CACHE_LINE_SIZE) producerState {
+        std::atomic<size_t> tail { 0 };
+        size_t cachedHead = 0;
+        std::atomic<uint64_t> pushed { 0 };
+        std::atomic<uint64_t> dropped { 0 };
+    };
+
+    // written by the consumer only
+    struct alignas(CACHE_LINE_SIZE) consumerState {
+        std::atomic<size_t> head { 0 };
+        size_t cachedTail = 0;
+        std::atomic<size_t> highWaterMark { 0 };
+    };
+
+    size_t capacity = 0;
+    size_t mask = 0;
+    std::unique_ptr<T[]> slots;
+    producerState producer;
+    consumerState consumer;
+};
+
+} // namespace kiteconnect
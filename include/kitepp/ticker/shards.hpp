@@ -0,0 +1,222 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../span.hpp"
+#include "ring.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+///
+/// @brief Spreads ticks across worker threads by instrument token. All ticks
+///        of an instrument go to the same worker, so they are processed in
+///        the order they were received, while ticks of different instruments
+///        are processed in parallel.
+///
+/// Each worker owns a `kc::spscRing` fed by the thread calling `dispatch()`.
+/// Idle workers spin briefly, then yield and finally sleep for short periods
+/// until ticks arrive.
+///
+class tickShards {
+
+  public:
+    ///
+    /// @brief Called on a worker thread with a batch of ticks of the
+    ///        instruments assigned to \a shard.
+    ///
+    using callback =
+        std::function<void(size_t shard, kc::span<const kc::compactTick>)>;
+
+    ///
+    /// @brief Start the workers.
+    ///
+    /// @param NumberOfShards number of worker threads
+    /// @param OnTicks        called by the workers with ticks of their shard
+    /// @param QueueCapacity  minimum number of ticks each worker's queue can
+    ///                       hold
+    /// @param Cpus           if not empty, worker `i` is pinned to CPU
+    ///                       `Cpus[i % Cpus.size()]`. Only supported on Linux
+    ///                       and ignored elsewhere.
+    ///
+    tickShards(size_t NumberOfShards, callback OnTicks, size_t QueueCapacity,
+        const std::vector<int>& Cpus = {})
+        : onTicks(std::move(OnTicks)) {
+        if (NumberOfShards == 0) {
+            throw kc::libException("number of shards can't be 0");
+        };
+        if (!onTicks) { throw kc::libException("shard callback isn't set"); };
+        shards.reserve(NumberOfShards);
+        for (size_t i = 0; i < NumberOfShards; i++) {
+            shards.push_back(std::make_unique<shard>(QueueCapacity));
+        };
+        try {
+            for (size_t i = 0; i < NumberOfShards; i++) {
+                shards[i]->worker = std::thread([this, i]() { work(i); });
+                if (!Cpus.empty()) {
+                    pin(shards[i]->worker, Cpus[i % Cpus.size()]);
+                };
+            };
+        } catch (...) {
+            stop();
+            throw;
+        };
+    };
+
+    tickShards(const tickShards&) = delete;
+    tickShards& operator=(const tickShards&) = delete;
+
+    /// @brief Stop the workers.
+    ~tickShards() { stop(); };
+
+    /// @brief Get the shard ticks of \a instrumentToken are dispatched to.
+    size_t shardOf(int32_t instrumentToken) const {
+        // tokens of a segment share their low byte, mix before scaling
+        // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+        const uint64_t hash =
+            (static_cast<uint32_t>(instrumentToken) * 0x9e3779b1ULL) &
+            0xffffffffULL;
+        return static_cast<size_t>((hash * shards.size()) >> 32U);
+        // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+    };
+
+    ///
+    /// @brief Push \a ticks to the queues of their shards. Should only be
+    ///        called by one thread. Ticks that don't fit in a full queue are
+    ///        dropped and counted in `getStats()`.
+    ///
+    void dispatch(kc::span<const kc::compactTick> ticks) {
+        for (const auto& Shard : shards) { Shard->pending.clear(); };
+        for (const kc::compactTick& tick : ticks) {
+            shards[shardOf(tick.instrumentToken)]->pending.push_back(tick);
+        };
+        for (const auto& Shard : shards) {
+            if (!Shard->pending.empty()) {
+                Shard->queue.tryPush(
+                    kc::span<const kc::compactTick>(Shard->pending));
+            };
+        };
+    };
+
+    /// @brief Get the number of shards.
+    size_t size() const { return shards.size(); };
+
+    /// @brief Get the queue metrics of \a Shard.
+    kc::queueStats getStats(size_t Shard) const {
+        return shards.at(Shard)->queue.stats();
+    };
+
+    ///
+    /// @brief Stop the workers once they have handled the ticks already in
+    ///        their queues. `dispatch()` shouldn't be called afterwards.
+    ///
+    void stop() {
+        stopped.store(true, std::memory_order_release);
+        for (const auto& Shard : shards) {
+            if (Shard->worker.joinable()) { Shard->worker.join(); };
+        };
+    };
+
+  private:
+    static constexpr size_t MAX_BATCH_SIZE = 256;
+    static constexpr unsigned int SPIN_ROUNDS = 64;
+    static constexpr unsigned int YIELD_ROUNDS = 64;
+    static constexpr std::chrono::microseconds IDLE_SLEEP { 50 };
+
+    struct shard {
+        explicit shard(size_t QueueCapacity): queue(QueueCapacity) {};
+
+        kc::spscRing<kc::compactTick> queue;
+        // ticks of the message being dispatched, only touched by the producer
+        std::vector<kc::compactTick> pending;
+        std::thread worker;
+    };
+
+    const callback onTicks;
+    std::vector<std::unique_ptr<shard>> shards;
+    std::atomic<bool> stopped { false };
+
+    void work(size_t idx) {
+        shard& Shard = *shards[idx];
+        std::vector<kc::compactTick> batch(MAX_BATCH_SIZE);
+        unsigned int idleRounds = 0;
+        while (true) {
+            // read before popping so ticks pushed before `stop()` are handled
+            const bool stopping = stopped.load(std::memory_order_acquire);
+            const size_t popped =
+                Shard.queue.tryPop(batch.data(), batch.size());
+            if (popped > 0) {
+                idleRounds = 0;
+                onTicks(idx, kc::span<const kc::compactTick>(batch, popped));
+                continue;
+            };
+            if (stopping) { return; };
+
+            idleRounds++;
+            if (idleRounds <= SPIN_ROUNDS) { continue; };
+            if (idleRounds <= SPIN_ROUNDS + YIELD_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(IDLE_SLEEP);
+            };
+        };
+    };
+
+    static void pin(std::thread& thread, int cpu) {
+#if defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (pthread_setaffinity_np(
+                thread.native_handle(), sizeof(cpu_set_t), &cpus) != 0) {
+            throw kc::libException("failed to set affinity of shard worker");
+        };
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    };
+};
+
+} // namespace kiteconnect
@@ -0,0 +1,400 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KITEPP_HAS_SHM
+#endif
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../span.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+namespace internal {
+namespace shm {
+
+// "kitetick"
+constexpr uint64_t MAGIC = 0x6b6974657469636bULL;
+// bumped whenever the layout below or `kc::compactTick` changes
+constexpr uint32_t VERSION = 1;
+constexpr size_t CACHE_LINE_SIZE = 64;
+constexpr size_t WORDS =
+    (sizeof(kc::compactTick) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "atomics shared between processes must be lock free");
+
+// the segment is a header followed by `capacity` slots
+struct alignas(CACHE_LINE_SIZE) header {
+    // written last by the publisher, once the rest is initialized
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t tickSize;
+    uint64_t capacity;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> published;
+};
+
+// `sequence` is 2 * position + 1 while the tick at `position` is written &
+// 2 * position + 2 once it is complete. Ticks are copied word by word
+// through atomics, like in `kc::lastValueCache`.
+struct alignas(CACHE_LINE_SIZE) slot {
+    std::atomic<uint64_t> sequence;
+    std::array<std::atomic<uint64_t>, WORDS> words;
+};
+
+inline size_t segmentSize(uint64_t capacity) {
+    return sizeof(header) + (capacity * sizeof(slot));
+};
+
+inline slot* slots(header* Header) {
+    return reinterpret_cast<slot*>(Header + 1); // NOLINT
+};
+
+inline const slot* slots(const header* Header) {
+    return reinterpret_cast<const slot*>(Header + 1); // NOLINT
+};
+
+[[noreturn]] inline void throwError(const std::string& what) {
+#if defined(KITEPP_HAS_SHM)
+    throw kc::libException(what + ": " + std::strerror(errno));
+#else
+    throw kc::libException(what + ": shared memory isn't supported");
+#endif
+};
+
+} // namespace shm
+} // namespace internal
+
+///
+/// @brief Writes ticks to a ring in POSIX shared memory, so that other
+///        processes can read them with `kc::shmReader` instead of opening
+///        their own websocket connections.
+///
+/// The publisher never waits for readers. A reader that falls more than the
+/// ring's capacity behind skips the overwritten ticks and counts them in
+/// `kc::shmReader::getLost()`.
+///
+class shmPublisher {
+
+  public:
+    ///
+    /// @brief Create the shared memory segment \a Name, replacing any segment
+    ///        with the same name.
+    ///
+    /// @param Name     name of the segment, e.g., "/kite-ticks". Shows up in
+    ///                 /dev/shm on Linux.
+    /// @param Capacity minimum number of ticks the ring can hold, rounded up
+    ///                 to a power of two
+    ///
+    shmPublisher(const std::string& Name, size_t Capacity): name(Name) {
+        if (Capacity == 0) {
+            throw kc::libException("capacity of a ring can't be 0");
+        };
+        while (capacity < Capacity) { capacity <<= 1U; };
+        size = internal::shm::segmentSize(capacity);
+#if defined(KITEPP_HAS_SHM)
+        // readers of a stale segment keep their mapping until they reopen
+        shm_unlink(name.c_str());
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd == -1) {
+            internal::shm::throwError("failed to create " + name);
+        };
+        void* mapped = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            mapped = mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        };
+        const int error = errno;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            shm_unlink(name.c_str());
+            errno = error;
+            internal::shm::throwError("failed to map " + name);
+        };
+        // the segment is zero filled, which is a valid state for the atomics
+        Header = static_cast<internal::shm::header*>(mapped);
+        Header->version = internal::shm::VERSION;
+        Header->tickSize = sizeof(kc::compactTick);
+        Header->capacity = capacity;
+        Header->magic.store(internal::shm::MAGIC, std::memory_order_release);
+#else
+        internal::shm::throwError("failed to create " + name);
+#endif
+    };
+
+    shmPublisher(const shmPublisher&) = delete;
+    shmPublisher& operator=(const shmPublisher&) = delete;
+
+    /// @brief Unmap & remove the segment. Readers keep their mapping.
+    ~shmPublisher() {
+#if defined(KITEPP_HAS_SHM)
+        munmap(Header, size);
+        shm_unlink(name.c_str());
+#endif
+    };
+
+    /// @brief Write \a ticks to the ring. Should only be called by one thread.
+    void publish(kc::span<const kc::compactTick> ticks) {
+        uint64_t position = Header->published.load(std::memory_order_relaxed);
+        internal::shm::slot* Slots = internal::shm::slots(Header);
+        std::array<uint64_t, internal::shm::WORDS> words {};
+        for (const kc::compactTick& tick : ticks) {
+            internal::shm::slot& Slot = Slots[position & (capacity - 1)];
+            std::memcpy(words.data(), &tick, sizeof(kc::compactTick));
+            Slot.sequence.store((2 * position) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < internal::shm::WORDS; i++) {
+                Slot.words[i].store(words[i], std::memory_order_relaxed);
+            };
+            Slot.sequence.store((2 * position) + 2, std::memory_order_release);
+            position++;
+        };
+        Header->published.store(position, std::memory_order_release);
+    };
+
+    /// @brief Get the name of the segment.
+    const std::string& getName() const { return name; };
+
+    /// @brief Get the number of ticks the ring can hold.
+    size_t getCapacity() const { return capacity; };
+
+    /// @brief Get the number of ticks published so far.
+    uint64_t getPublished() const {
+        return Header->published.load(std::memory_order_relaxed);
+    };
+
+  private:
+    const std::string name;
+    size_t capacity = 1;
+    size_t size = 0;
+    internal::shm::header* Header = nullptr;
+};
+
+///
+/// @brief Reads the ticks a `kc::shmPublisher`, usually a `kc::ticker` with
+///        `enableSharedMemoryBus()`, writes to shared memory.
+///
+/// @paragraph ex1 example
+/// @code
+/// kc::shmReader Reader("/kite-ticks");
+/// Reader.onTicks = [](kc::shmReader* Reader,
+///                      const std::vector<kc::compactTick>& Ticks) { ... };
+/// Reader.run();
+/// @endcode
+///
+class shmReader {
+
+  public:
+    /// called with ticks read by `poll()` or `run()`
+    std::function<void(
+        shmReader* reader, const std::vector<kc::compactTick>& ticks)>
+        onTicks;
+
+    ///
+    /// @brief Map the segment \a Name. Only ticks published after this are
+    ///        read.
+    ///
+    /// @param Name         name of the segment the publisher created
+    /// @param MaxBatchSize maximum number of ticks passed to `onTicks` at once
+    ///
+    explicit shmReader(
+        const std::string& Name, size_t MaxBatchSize = DEFAULT_MAX_BATCH_SIZE)
+        : name(Name), maxBatchSize(std::max<size_t>(MaxBatchSize, 1)) {
+#if defined(KITEPP_HAS_SHM)
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd == -1) { internal::shm::throwError("failed to open " + name); };
+        struct stat info {};
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0) {
+            size = static_cast<size_t>(info.st_size);
+            if (size >= sizeof(internal::shm::header)) {
+                mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            } else {
+                errno = EINVAL;
+            };
+        };
+        const int error = errno;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            errno = error;
+            internal::shm::throwError("failed to map " + name);
+        };
+        Header = static_cast<const internal::shm::header*>(mapped);
+        if (Header->magic.load(std::memory_order_acquire) !=
+                internal::shm::MAGIC ||
+            Header->version != internal::shm::VERSION ||
+            Header->tickSize != sizeof(kc::compactTick) ||
+            size < internal::shm::segmentSize(Header->capacity)) {
+            munmap(const_cast<internal::shm::header*>(Header), size);
+            throw kc::libException(name + " isn't a compatible tick bus");
+        };
+        capacity = Header->capacity;
+        cursor = Header->published.load(std::memory_order_acquire);
+#else
+        internal::shm::throwError("failed to open " + name);
+#endif
+    };
+
+    shmReader(const shmReader&) = delete;
+    shmReader& operator=(const shmReader&) = delete;
+
+    ~shmReader() {
+#if defined(KITEPP_HAS_SHM)
+        munmap(const_cast<internal::shm::header*>(Header), size);
+#endif
+    };
+
+    ///
+    /// @brief Read the ticks published since the last call, without waiting,
+    ///        calling `onTicks` with batches of them.
+    ///
+    /// @return size_t number of ticks read
+    ///
+    size_t poll() {
+        size_t read = 0;
+        while (true) {
+            const uint64_t published =
+                Header->published.load(std::memory_order_acquire);
+            if (published - cursor > capacity) {
+                // overwritten, skip to the oldest tick still in the ring
+                lost += published - cursor - capacity;
+                cursor = published - capacity;
+            };
+            if (cursor == published) { return read; };
+
+            const size_t count = static_cast<size_t>(
+                std::min<uint64_t>(published - cursor, maxBatchSize));
+            ticks.resize(count);
+            size_t copied = 0;
+            while (copied < count && readTick(cursor, ticks[copied])) {
+                cursor++;
+                copied++;
+            };
+            ticks.resize(copied);
+            if (!ticks.empty()) {
+                read += copied;
+                if (onTicks) { onTicks(this, ticks); };
+            };
+            if (copied < count) {
+                // overwritten while being read
+                lost++;
+                cursor++;
+            };
+        };
+    };
+
+    ///
+    /// @brief Call `poll()` until `stop()` is called. Spins briefly when idle,
+    ///        then yields and finally sleeps for short periods.
+    ///
+    void run() {
+        unsigned int idleRounds = 0;
+        while (!stopped.load(std::memory_order_acquire)) {
+            if (poll() > 0) {
+                idleRounds = 0;
+                continue;
+            };
+            idleRounds++;
+            if (idleRounds <= SPIN_ROUNDS) { continue; };
+            if (idleRounds <= SPIN_ROUNDS + YIELD_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(IDLE_SLEEP);
+            };
+        };
+    };
+
+    /// @brief Have `run()` return. Can be called from any thread.
+    void stop() { stopped.store(true, std::memory_order_release); };
+
+    /// @brief Get the number of ticks overwritten before they could be read.
+    uint64_t getLost() const { return lost; };
+
+    /// @brief Get the name of the segment.
+    const std::string& getName() const { return name; };
+
+  private:
+    static constexpr size_t DEFAULT_MAX_BATCH_SIZE = 512;
+    static constexpr unsigned int SPIN_ROUNDS = 64;
+    static constexpr unsigned int YIELD_ROUNDS = 64;
+    static constexpr std::chrono::microseconds IDLE_SLEEP { 50 };
+
+    const std::string name;
+    const size_t maxBatchSize;
+    size_t size = 0;
+    uint64_t capacity = 0;
+    const internal::shm::header* Header = nullptr;
+    uint64_t cursor = 0;
+    uint64_t lost = 0;
+    std::vector<kc::compactTick> ticks;
+    std::atomic<bool> stopped { false };
+
+    // false if the tick at `position` was overwritten
+    bool readTick(uint64_t position, kc::compactTick& tick) const {
+        const internal::shm::slot& Slot =
+            internal::shm::slots(Header)[position & (capacity - 1)];
+        const uint64_t expected = (2 * position) + 2;
+        if (Slot.sequence.load(std::memory_order_acquire) != expected) {
+            return false;
+        };
+        std::array<uint64_t, internal::shm::WORDS> words {};
+        for (size_t i = 0; i < internal::shm::WORDS; i++) {
+            words[i] = Slot.words[i].load(std::memory_order_relaxed);
+        };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (Slot.sequence.load(std::memory_order_relaxed) != expected) {
+            return false;
+        };
+        std::memcpy(static_cast<void*>(&tick), words.data(), sizeof(tick));
+        return true;
+    };
+};
+
+} // namespace kiteconnect
@@ -0,0 +1,384 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+/**
+ * @file simd.hpp
+ * @brief Vectorized decoding of the quote header and market depth of quote
+ * and full packets. The kernel is picked at runtime based on the CPU; define
+ * `KITEPP_DISABLE_SIMD` to always use the scalar one.
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "../responses/ws.hpp"
+#include "binary.hpp"
+
+// clang-format off
+#if !defined(KITEPP_DISABLE_SIMD) && defined(__GNUC__) &&                      \
+    (defined(__x86_64__) || defined(__i386__))
+#define KITEPP_X86_SIMD 1
+#include <immintrin.h>
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define KITEPP_TARGET(isa) __attribute__((target(isa)))
+#endif
+// clang-format on
+
+namespace kiteconnect::internal::binary {
+
+namespace kc = kiteconnect;
+
+/// Fields of the header shared by quote and full packets.
+struct quoteHeader {
+    /// Indices of \a prices.
+    enum PRICE : size_t
+    {
+        LAST_PRICE,
+        AVERAGE_TRADE_PRICE,
+        OPEN,
+        HIGH,
+        LOW,
+        CLOSE
+    };
+
+    int32_t instrumentToken = -1;
+    int32_t lastTradedQuantity = -1;
+    int32_t volumeTraded = -1;
+    int32_t totalBuyQuantity = -1;
+    int32_t totalSellQuantity = -1;
+    std::array<double, CLOSE + 1> prices {};
+};
+
+using quoteHeaderDecoder = void (*)(const char*, double, quoteHeader&);
+using depthDecoder = void (*)(
+    const char*, double, kc::depthWS*, kc::depthWS*);
+
+namespace scalar {
+
+///
+/// @brief Decode the quote header of \a packet.
+///
+/// @param packet  quote or full packet
+/// @param divisor divisor of prices
+/// @param header  decoded header
+///
+inline void decodeQuoteHeader(
+    const char* packet, double divisor, quoteHeader& header) {
+    using Layout = layout::quote;
+    header.instrumentToken = unpack<int32_t>(packet + Layout::INSTRUMENT_TOKEN);
+    header.lastTradedQuantity =
+        unpack<int32_t>(packet + Layout::LAST_TRADED_QUANTITY);
+    header.volumeTraded = unpack<int32_t>(packet + Layout::VOLUME_TRADED);
+    header.totalBuyQuantity =
+        unpack<int32_t>(packet + Layout::TOTAL_BUY_QUANTITY);
+    header.totalSellQuantity =
+        unpack<int32_t>(packet + Layout::TOTAL_SELL_QUANTITY);
+    header.prices[quoteHeader::LAST_PRICE] =
+        unpack<int32_t>(packet + Layout::LAST_PRICE) / divisor;
+    header.prices[quoteHeader::AVERAGE_TRADE_PRICE] =
+        unpack<int32_t>(packet + Layout::AVERAGE_TRADE_PRICE) / divisor;
+    header.prices[quoteHeader::OPEN] =
+        unpack<int32_t>(packet + Layout::OPEN) / divisor;
+    header.prices[quoteHeader::HIGH] =
+        unpack<int32_t>(packet + Layout::HIGH) / divisor;
+    header.prices[quoteHeader::LOW] =
+        unpack<int32_t>(packet + Layout::LOW) / divisor;
+    header.prices[quoteHeader::CLOSE] =
+        unpack<int32_t>(packet + Layout::CLOSE) / divisor;
+};
+
+///
+/// @brief Decode the market depth block of a full packet.
+///
+/// @param depth   start of the depth block
+/// @param divisor divisor of prices
+/// @param buy     first of 5 buy entries to decode into
+/// @param sell    first of 5 sell entries to decode into
+///
+inline void decodeDepth(const char* depth, double divisor, kc::depthWS* buy,
+    kc::depthWS* sell) {
+    using Layout = layout::full;
+    constexpr size_t entriesPerSide = Layout::DEPTH_ENTRIES / 2;
+    for (size_t i = 0; i < Layout::DEPTH_ENTRIES; i++) {
+        kc::depthWS& entry =
+            (i < entriesPerSide) ? buy[i] : sell[i - entriesPerSide];
+        entry.quantity = unpack<int32_t>(depth + Layout::DEPTH_QUANTITY);
+        entry.price = unpack<int32_t>(depth + Layout::DEPTH_PRICE) / divisor;
+        entry.orders = unpack<int16_t>(depth + Layout::DEPTH_ORDERS);
+        depth += Layout::DEPTH_ENTRY_SIZE;
+    };
+};
+
+} // namespace scalar
+
+#ifdef KITEPP_X86_SIMD
+namespace ssse3 {
+
+constexpr int ORDERS_SHIFT = 16;
+
+/// @brief Load 16 bytes and reverse the byte order of each 32-bit lane.
+KITEPP_TARGET("ssse3") inline __m128i loadSwapped(const char* bytes) {
+    const __m128i mask =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)), mask);
+};
+
+/// @brief Get 32-bit lane \a Lane of \a words.
+template <int Lane>
+KITEPP_TARGET("ssse3")
+inline int32_t lane(__m128i words) {
+    return _mm_cvtsi128_si32(
+        _mm_shuffle_epi32(words, _MM_SHUFFLE(Lane, Lane, Lane, Lane)));
+};
+
+/// @brief Convert the two lower lanes of \a words and divide by \a divisor.
+KITEPP_TARGET("ssse3")
+inline __m128d toPrices(__m128i words, __m128d divisor) {
+    return _mm_div_pd(_mm_cvtepi32_pd(words), divisor);
+};
+
+/// @brief Set quantity and orders of \a entry from its byte-swapped words.
+inline void setEntry(kc::depthWS& entry, int32_t quantity, int32_t orders) {
+    entry.quantity = quantity;
+    entry.orders =
+        static_cast<int16_t>(static_cast<uint32_t>(orders) >> ORDERS_SHIFT);
+};
+
+///
+/// @brief Decode quantity and orders of four consecutive depth entries
+///        starting at \a depth into \a entry(first).. \a entry(first + 3).
+///
+/// @return __m128i the entries' prices, not yet divided
+///
+template <class EntryFn>
+KITEPP_TARGET("ssse3")
+inline __m128i decodeFourEntries(
+    const char* depth, const EntryFn& entry, size_t first) {
+    // a = [q0, p0, o0, q1], b = [p1, o1, q2, p2], c = [o2, q3, p3, o3]
+    const __m128i a = loadSwapped(depth);
+    const __m128i b = loadSwapped(depth + 16);
+    const __m128i c = loadSwapped(depth + 32);
+    setEntry(entry(first), lane<0>(a), lane<2>(a));
+    setEntry(entry(first + 1), lane<3>(a), lane<1>(b));
+    setEntry(entry(first + 2), lane<2>(b), lane<0>(c));
+    setEntry(entry(first + 3), lane<1>(c), lane<3>(c));
+
+    // [p0, p1, o0, o1] and [p2, p3, 0, 0]
+    const __m128i low = _mm_unpacklo_epi32(_mm_srli_si128(a, 4), b);
+    const __m128i high =
+        _mm_unpacklo_epi32(_mm_srli_si128(b, 12), _mm_srli_si128(c, 8));
+    return _mm_unpacklo_epi64(low, high);
+};
+
+///
+/// @brief Decode quantity and orders of the last two depth entries, starting
+///        at \a depth, into \a entry(first) and \a entry(first + 1).
+///
+/// @return __m128i the entries' prices in the two lower lanes
+///
+template <class EntryFn>
+KITEPP_TARGET("ssse3")
+inline __m128i decodeTwoEntries(
+    const char* depth, const EntryFn& entry, size_t first) {
+    // a = [q0, p0, o0, q1], b = [o0, q1, p1, o1]
+    const __m128i a = loadSwapped(depth);
+    const __m128i b = loadSwapped(depth + 8);
+    setEntry(entry(first), lane<0>(a), lane<2>(a));
+    setEntry(entry(first + 1), lane<1>(b), lane<3>(b));
+    return _mm_unpacklo_epi32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 8));
+};
+
+/// @brief Store the two \a prices into \a first and \a second.
+KITEPP_TARGET("ssse3")
+inline void setPrices(
+    __m128d prices, kc::depthWS& first, kc::depthWS& second) {
+    _mm_storel_pd(&first.price, prices);
+    _mm_storeh_pd(&second.price, prices);
+};
+
+/// \copydoc kiteconnect::internal::binary::scalar::decodeQuoteHeader
+KITEPP_TARGET("ssse3")
+inline void decodeQuoteHeader(
+    const char* packet, double divisor, quoteHeader& header) {
+    // words 0-3, 4-7 and 7-10 of the 11 word header
+    const __m128i first = loadSwapped(packet);
+    const __m128i second = loadSwapped(packet + 16);
+    const __m128i third = loadSwapped(packet + 28);
+    const __m128d div = _mm_set1_pd(divisor);
+
+    // last price & average trade price, open & high, low & close
+    double* prices = header.prices.data();
+    _mm_storeu_pd(prices + quoteHeader::LAST_PRICE,
+        toPrices(_mm_shuffle_epi32(first, _MM_SHUFFLE(3, 3, 3, 1)), div));
+    _mm_storeu_pd(prices + quoteHeader::OPEN, toPrices(third, div));
+    _mm_storeu_pd(prices + quoteHeader::LOW,
+        toPrices(_mm_unpackhi_epi64(third, third), div));
+
+    header.instrumentToken = lane<0>(first);
+    header.lastTradedQuantity = lane<2>(first);
+    header.volumeTraded = lane<0>(second);
+    header.totalBuyQuantity = lane<1>(second);
+    header.totalSellQuantity = lane<2>(second);
+};
+
+/// \copydoc kiteconnect::internal::binary::scalar::decodeDepth
+KITEPP_TARGET("ssse3")
+inline void decodeDepth(const char* depth, double divisor, kc::depthWS* buy,
+    kc::depthWS* sell) {
+    constexpr size_t entriesPerSide = layout::full::DEPTH_ENTRIES / 2;
+    constexpr size_t entrySize = layout::full::DEPTH_ENTRY_SIZE;
+    const auto entry = [buy, sell](size_t i) -> kc::depthWS& {
+        return (i < entriesPerSide) ? buy[i] : sell[i - entriesPerSide];
+    };
+    const __m128d div = _mm_set1_pd(divisor);
+
+    for (size_t i = 0; i < 8; i += 4) {
+        const __m128i prices =
+            decodeFourEntries(depth + i * entrySize, entry, i);
+        setPrices(toPrices(prices, div), entry(i), entry(i + 1));
+        setPrices(toPrices(_mm_unpackhi_epi64(prices, prices), div),
+            entry(i + 2), entry(i + 3));
+    };
+    const __m128i prices = decodeTwoEntries(depth + 8 * entrySize, entry, 8);
+    setPrices(toPrices(prices, div), entry(8), entry(9));
+};
+
+} // namespace ssse3
+
+namespace avx2 {
+
+/// @brief Load 32 bytes and reverse the byte order of each 32-bit lane.
+KITEPP_TARGET("avx2") inline __m256i loadSwapped(const char* bytes) {
+    const __m256i mask =
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes)), mask);
+};
+
+/// \copydoc kiteconnect::internal::binary::scalar::decodeQuoteHeader
+KITEPP_TARGET("avx2")
+inline void decodeQuoteHeader(
+    const char* packet, double divisor, quoteHeader& header) {
+    // words 0-7 and 7-10 of the 11 word header
+    const __m256i first = loadSwapped(packet);
+    const __m128i second = ssse3::loadSwapped(packet + 28);
+
+    // last price, average trade price, open & high in one go
+    const __m128i lowerPrices =
+        _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+            first, _mm256_setr_epi32(1, 3, 0, 0, 0, 0, 0, 0)));
+    double* prices = header.prices.data();
+    _mm256_storeu_pd(prices + quoteHeader::LAST_PRICE,
+        _mm256_div_pd(
+            _mm256_cvtepi32_pd(_mm_unpacklo_epi64(lowerPrices, second)),
+            _mm256_set1_pd(divisor)));
+    _mm_storeu_pd(prices + quoteHeader::LOW,
+        ssse3::toPrices(
+            _mm_unpackhi_epi64(second, second), _mm_set1_pd(divisor)));
+
+    const __m128i lower = _mm256_castsi256_si128(first);
+    const __m128i upper = _mm256_extracti128_si256(first, 1);
+    header.instrumentToken = ssse3::lane<0>(lower);
+    header.lastTradedQuantity = ssse3::lane<2>(lower);
+    header.volumeTraded = ssse3::lane<0>(upper);
+    header.totalBuyQuantity = ssse3::lane<1>(upper);
+    header.totalSellQuantity = ssse3::lane<2>(upper);
+};
+
+/// \copydoc kiteconnect::internal::binary::scalar::decodeDepth
+KITEPP_TARGET("avx2")
+inline void decodeDepth(const char* depth, double divisor, kc::depthWS* buy,
+    kc::depthWS* sell) {
+    constexpr size_t entriesPerSide = layout::full::DEPTH_ENTRIES / 2;
+    constexpr size_t entrySize = layout::full::DEPTH_ENTRY_SIZE;
+    const auto entry = [buy, sell](size_t i) -> kc::depthWS& {
+        return (i < entriesPerSide) ? buy[i] : sell[i - entriesPerSide];
+    };
+    const __m256d div = _mm256_set1_pd(divisor);
+
+    // four prices are converted and divided at once
+    for (size_t i = 0; i < 8; i += 4) {
+        const __m256d prices = _mm256_div_pd(
+            _mm256_cvtepi32_pd(
+                ssse3::decodeFourEntries(depth + i * entrySize, entry, i)),
+            div);
+        ssse3::setPrices(
+            _mm256_castpd256_pd128(prices), entry(i), entry(i + 1));
+        ssse3::setPrices(
+            _mm256_extractf128_pd(prices, 1), entry(i + 2), entry(i + 3));
+    };
+    const __m128i prices =
+        ssse3::decodeTwoEntries(depth + 8 * entrySize, entry, 8);
+    ssse3::setPrices(
+        ssse3::toPrices(prices, _mm256_castpd256_pd128(div)), entry(8),
+        entry(9));
+};
+
+} // namespace avx2
+#endif
+
+///
+/// @brief Pick the fastest quote header and depth decoders supported by the
+///        CPU. Detection runs once.
+///
+/// @return std::pair<quoteHeaderDecoder, depthDecoder> decoders
+///
+inline const std::pair<quoteHeaderDecoder, depthDecoder>& selectDecoders() {
+    static const std::pair<quoteHeaderDecoder, depthDecoder> decoders =
+        []() -> std::pair<quoteHeaderDecoder, depthDecoder> {
+#ifdef KITEPP_X86_SIMD
+        if (__builtin_cpu_supports("avx2")) {
+            return { avx2::decodeQuoteHeader, avx2::decodeDepth };
+        };
+        if (__builtin_cpu_supports("ssse3")) {
+            return { ssse3::decodeQuoteHeader, ssse3::decodeDepth };
+        };
+#endif
+        return { scalar::decodeQuoteHeader, scalar::decodeDepth };
+    }();
+    return decoders;
+};
+
+/// \copydoc kiteconnect::internal::binary::scalar::decodeQuoteHeader
+inline void decodeQuoteHeader(
+    const char* packet, double divisor, quoteHeader& header) {
+    selectDecoders().first(packet, divisor, header);
+};
+
+/// \copydoc kiteconnect::internal::binary::scalar::decodeDepth
+inline void decodeDepth(const char* depth, double divisor, kc::depthWS* buy,
+    kc::depthWS* sell) {
+    selectDecoders().second(depth, divisor, buy, sell);
+};
+
+} // namespace kiteconnect::internal::binary
@@ -0,0 +1,422 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/ws.hpp"
+#include "../userconstants.hpp"
+
+namespace kiteconnect::internal {
+
+using std::string;
+namespace kc = kiteconnect;
+
+constexpr size_t NUMBER_OF_MODES = 3;
+
+/// @brief Get the `kc::TICK_MODE` of \a mode, one of `MODE_LTP`,
+///        `MODE_QUOTE` & `MODE_FULL`.
+inline kc::TICK_MODE toTickMode(const string& mode) {
+    if (mode == MODE_LTP) { return kc::TICK_MODE::LTP; };
+    if (mode == MODE_QUOTE) { return kc::TICK_MODE::QUOTE; };
+    if (mode == MODE_FULL) { return kc::TICK_MODE::FULL; };
+    throw kc::libException("invalid mode: " + mode);
+};
+
+/// @brief Get the name of \a mode used in control frames.
+inline const string& modeName(kc::TICK_MODE mode) {
+    switch (mode) {
+        case kc::TICK_MODE::LTP: return MODE_LTP;
+        case kc::TICK_MODE::QUOTE: return MODE_QUOTE;
+        default: return MODE_FULL;
+    };
+};
+
+///
+/// @brief Maps instrument tokens to dense slots `0` to `size() - 1`, so that
+///        per-instrument state can be kept in plain arrays indexed by slot.
+///
+/// Uses open addressing with linear probing. Erasing a token moves the token
+/// in the last slot into the freed one; arrays indexed by slot should do the
+/// same.
+///
+class tokenIndex {
+
+  public:
+    static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+    /// @brief Get the slot of \a instrumentToken, `NOT_FOUND` if absent.
+    uint32_t find(int32_t instrumentToken) const {
+        if (tokens.empty()) { return NOT_FOUND; };
+        for (size_t pos = home(instrumentToken);;
+             pos = (pos + 1) & (keys.size() - 1)) {
+            if (keys[pos] == instrumentToken) { return slots[pos]; };
+            if (keys[pos] == EMPTY) { return NOT_FOUND; };
+        };
+    };
+
+    ///
+    /// @brief Add \a instrumentToken if absent.
+    ///
+    /// @return std::pair<uint32_t, bool> slot of \a instrumentToken & whether
+    ///         it was added, in which case the slot is `size() - 1`
+    ///
+    std::pair<uint32_t, bool> insert(int32_t instrumentToken) {
+        const uint32_t existing = find(instrumentToken);
+        if (existing != NOT_FOUND) { return { existing, false }; };
+        // keep the load factor under 1/2
+        if ((tokens.size() + 1) * 2 > keys.size()) { grow(); };
+        const auto slot = static_cast<uint32_t>(tokens.size());
+        place(instrumentToken, slot);
+        tokens.push_back(instrumentToken);
+        return { slot, true };
+    };
+
+    ///
+    /// @brief Remove \a instrumentToken, moving the token in the last slot
+    ///        into its slot.
+    ///
+    /// @return uint32_t slot \a instrumentToken had, `NOT_FOUND` if absent
+    ///
+    uint32_t erase(int32_t instrumentToken) {
+        if (tokens.empty()) { return NOT_FOUND; };
+        size_t pos = home(instrumentToken);
+        while (keys[pos] != instrumentToken) {
+            if (keys[pos] == EMPTY) { return NOT_FOUND; };
+            pos = (pos + 1) & (keys.size() - 1);
+        };
+        const uint32_t slot = slots[pos];
+
+        // shift following entries back instead of leaving a tombstone
+        size_t next = pos;
+        while (true) {
+            next = (next + 1) & (keys.size() - 1);
+            if (keys[next] == EMPTY) { break; };
+            const size_t nextHome = home(keys[next]);
+            // entries stay put if their home is cyclically in (pos, next]
+            const bool stays = (pos <= next) ?
+                                   (pos < nextHome && nextHome <= next) :
+                                   (pos < nextHome || nextHome <= next);
+            if (stays) { continue; };
+            keys[pos] = keys[next];
+            slots[pos] = slots[next];
+            pos = next;
+        };
+        keys[pos] = EMPTY;
+
+        const int32_t last = tokens.back();
+        tokens.pop_back();
+        if (slot != tokens.size()) {
+            tokens[slot] = last;
+            slots[position(last)] = slot;
+        };
+        return slot;
+    };
+
+    /// @brief Get the token in \a slot.
+    int32_t token(uint32_t slot) const { return tokens[slot]; };
+
+    /// @brief Get the tokens, indexed by slot.
+    const std::vector<int32_t>& getTokens() const { return tokens; };
+
+    size_t size() const { return tokens.size(); };
+
+    bool empty() const { return tokens.empty(); };
+
+    void clear() {
+        tokens.clear();
+        keys.clear();
+        slots.clear();
+    };
+
+  private:
+    static constexpr int32_t EMPTY = std::numeric_limits<int32_t>::min();
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<int32_t> keys;
+    std::vector<uint32_t> slots;
+    std::vector<int32_t> tokens;
+
+    size_t home(int32_t instrumentToken) const {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        const uint64_t hash = static_cast<uint32_t>(instrumentToken) *
+                              0x9e3779b97f4a7c15ULL;
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        return static_cast<size_t>(hash >> 32U) & (keys.size() - 1);
+    };
+
+    size_t position(int32_t instrumentToken) const {
+        size_t pos = home(instrumentToken);
+        while (keys[pos] != instrumentToken) {
+            pos = (pos + 1) & (keys.size() - 1);
+        };
+        return pos;
+    };
+
+    void place(int32_t instrumentToken, uint32_t slot) {
+        size_t pos = home(instrumentToken);
+        while (keys[pos] != EMPTY) { pos = (pos + 1) & (keys.size() - 1); };
+        keys[pos] = instrumentToken;
+        slots[pos] = slot;
+    };
+
+    void grow() {
+        const size_t capacity =
+            keys.empty() ? MIN_CAPACITY : keys.size() * 2;
+        keys.assign(capacity, EMPTY);
+        slots.assign(capacity, NOT_FOUND);
+        for (size_t slot = 0; slot < tokens.size(); slot++) {
+            place(tokens[slot], static_cast<uint32_t>(slot));
+        };
+    };
+};
+
+///
+/// @brief Subscribed instruments & their state, kept in arrays indexed by the
+///        slots of a `tokenIndex`.
+///
+class subscriptionTable {
+
+  public:
+    /// @brief Get the slot of \a instrumentToken, `tokenIndex::NOT_FOUND` if
+    ///        it isn't subscribed.
+    uint32_t find(int32_t instrumentToken) const {
+        return index.find(instrumentToken);
+    };
+
+    /// @brief Add \a instrumentToken, in `quote` mode, if absent & get its
+    ///        slot.
+    uint32_t add(int32_t instrumentToken) {
+        const auto [slot, added] = index.insert(instrumentToken);
+        if (added) {
+            modes.push_back(kc::TICK_MODE::QUOTE);
+            refCounts.push_back(0);
+            modeRefCounts.push_back({});
+        };
+        return slot;
+    };
+
+    /// @brief Remove \a instrumentToken. Slots of other instruments may
+    ///        change.
+    bool remove(int32_t instrumentToken) {
+        const uint32_t slot = index.erase(instrumentToken);
+        if (slot == tokenIndex::NOT_FOUND) { return false; };
+        moveLast(modes, slot);
+        moveLast(refCounts, slot);
+        moveLast(modeRefCounts, slot);
+        return true;
+    };
+
+    int32_t token(uint32_t slot) const { return index.token(slot); };
+
+    /// @brief Get the subscribed tokens, indexed by slot.
+    const std::vector<int32_t>& getTokens() const {
+        return index.getTokens();
+    };
+
+    kc::TICK_MODE& mode(uint32_t slot) { return modes[slot]; };
+    kc::TICK_MODE mode(uint32_t slot) const { return modes[slot]; };
+
+    /// number of subscribers of the instrument
+    uint32_t& refCount(uint32_t slot) { return refCounts[slot]; };
+    uint32_t refCount(uint32_t slot) const { return refCounts[slot]; };
+
+    /// number of subscribers of the instrument that asked for \a mode
+    uint32_t& modeRefCount(uint32_t slot, kc::TICK_MODE mode) {
+        return modeRefCounts[slot][static_cast<size_t>(mode)];
+    };
+    uint32_t modeRefCount(uint32_t slot, kc::TICK_MODE mode) const {
+        return modeRefCounts[slot][static_cast<size_t>(mode)];
+    };
+
+    size_t size() const { return index.size(); };
+
+    bool empty() const { return index.empty(); };
+
+  private:
+    tokenIndex index;
+    std::vector<kc::TICK_MODE> modes;
+    std::vector<uint32_t> refCounts;
+    std::vector<std::array<uint32_t, NUMBER_OF_MODES>> modeRefCounts;
+
+    template <class T>
+    static void moveLast(std::vector<T>& column, uint32_t slot) {
+        column[slot] = column.back();
+        column.pop_back();
+    };
+};
+
+///
+/// @brief Changes to what is subscribed on the connection, to be sent with
+///        a `controlQueue`.
+///
+struct subscriptionChanges {
+    std::vector<int> subscribed;
+    std::vector<int> unsubscribed;
+    /// instruments whose mode should be set, indexed by `kc::TICK_MODE`
+    std::array<std::vector<int>, NUMBER_OF_MODES> modes;
+
+    bool empty() const {
+        if (!subscribed.empty() || !unsubscribed.empty()) { return false; };
+        for (const auto& tokens : modes) {
+            if (!tokens.empty()) { return false; };
+        };
+        return true;
+    };
+};
+
+///
+/// @brief Reference counts subscriptions of several subscribers sharing a
+///        connection.
+///
+/// Every subscriber asks for instruments in a mode of its own. An instrument
+/// stays subscribed while any subscriber asks for it, in the highest mode
+/// asked for, e.g., `full` if one subscriber asks for `ltp` and another for
+/// `full`. Only changes to that are returned, so asking for an instrument
+/// that is already subscribed in a high enough mode changes nothing on the
+/// connection.
+///
+class subscriberRegistry {
+
+  public:
+    ///
+    /// @brief Have \a subscriber ask for \a instrumentTokens in \a mode,
+    ///        replacing the mode it asked for earlier, if any.
+    ///
+    /// @return subscriptionChanges changes to the connection
+    ///
+    subscriptionChanges request(uint32_t subscriber,
+        const std::vector<int>& instrumentTokens, kc::TICK_MODE mode) {
+        subscriptionChanges changes;
+        auto& requested = requests[subscriber];
+        for (const int token : instrumentTokens) {
+            const uint32_t slot = table.add(token);
+            const bool isNew = table.refCount(slot) == 0;
+            const auto [it, added] = requested.try_emplace(token, mode);
+            if (added) {
+                table.refCount(slot)++;
+            } else if (it->second != mode) {
+                table.modeRefCount(slot, it->second)--;
+                it->second = mode;
+            } else {
+                continue;
+            };
+            table.modeRefCount(slot, mode)++;
+
+            const kc::TICK_MODE effective = highestMode(slot);
+            if (isNew) {
+                changes.subscribed.push_back(token);
+                // instruments are subscribed in `quote` mode
+                if (effective == kc::TICK_MODE::QUOTE) {
+                    table.mode(slot) = effective;
+                    continue;
+                };
+            } else if (effective == table.mode(slot)) {
+                continue;
+            };
+            table.mode(slot) = effective;
+            changes.modes[static_cast<size_t>(effective)].push_back(token);
+        };
+        if (requested.empty()) { requests.erase(subscriber); };
+        return changes;
+    };
+
+    ///
+    /// @brief Drop \a subscriber's interest in \a instrumentTokens.
+    ///        Instruments no other subscriber asked for are unsubscribed.
+    ///
+    /// @return subscriptionChanges changes to the connection
+    ///
+    subscriptionChanges release(
+        uint32_t subscriber, const std::vector<int>& instrumentTokens) {
+        subscriptionChanges changes;
+        auto found = requests.find(subscriber);
+        if (found == requests.end()) { return changes; };
+        auto& requested = found->second;
+        for (const int token : instrumentTokens) {
+            auto it = requested.find(token);
+            if (it == requested.end()) { continue; };
+            const uint32_t slot = table.find(token);
+            table.modeRefCount(slot, it->second)--;
+            requested.erase(it);
+            if (--table.refCount(slot) == 0) {
+                table.remove(token);
+                changes.unsubscribed.push_back(token);
+                continue;
+            };
+            const kc::TICK_MODE effective = highestMode(slot);
+            if (effective != table.mode(slot)) {
+                table.mode(slot) = effective;
+                changes.modes[static_cast<size_t>(effective)].push_back(token);
+            };
+        };
+        if (requested.empty()) { requests.erase(found); };
+        return changes;
+    };
+
+    /// @brief Drop every instrument \a subscriber asked for.
+    subscriptionChanges releaseAll(uint32_t subscriber) {
+        auto found = requests.find(subscriber);
+        if (found == requests.end()) { return {}; };
+        std::vector<int> instrumentTokens;
+        instrumentTokens.reserve(found->second.size());
+        for (const auto& [token, mode] : found->second) {
+            instrumentTokens.push_back(token);
+        };
+        return release(subscriber, instrumentTokens);
+    };
+
+    /// @brief Get the subscribed instruments, their modes & reference counts.
+    const subscriptionTable& getTable() const { return table; };
+
+    bool empty() const { return table.empty(); };
+
+  private:
+    subscriptionTable table;
+    // instruments & modes asked for by each subscriber
+    std::unordered_map<uint32_t, std::unordered_map<int, kc::TICK_MODE>>
+        requests;
+
+    kc::TICK_MODE highestMode(uint32_t slot) const {
+        if (table.modeRefCount(slot, kc::TICK_MODE::FULL) > 0) {
+            return kc::TICK_MODE::FULL;
+        };
+        if (table.modeRefCount(slot, kc::TICK_MODE::QUOTE) > 0) {
+            return kc::TICK_MODE::QUOTE;
+        };
+        return kc::TICK_MODE::LTP;
+    };
+};
+
+} // namespace kiteconnect::internal
@@ -25,15 +25,17 @@
 
 #pragma once
 
-#include <algorithm> //reverse
 #include <atomic>
 #include <chrono>
 #include <cstdint>
-#include <cstring> //memcpy
 #include <functional>
+#include <future>
 #include <ios>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -42,6 +44,16 @@
 
 #include "../exceptions.hpp"
 #include "../responses/responses.hpp"
+#include "../span.hpp"
+#include "cache.hpp"
+#include "control.hpp"
+#include "multicast.hpp"
+#include "orders.hpp"
+#include "postback.hpp"
+#include "ring.hpp"
+#include "shards.hpp"
+#include "shm.hpp"
+#include "subscriptions.hpp"
 #include "../userconstants.hpp" //modes
 #include "../utils.hpp"
 
@@ -73,6 +85,41 @@ class ticker {
     /// @brief Called when ticks are received.
     std::function<void(ticker* ws, const std::vector<kc::tick>& ticks)> onTicks;
 
+    ///
+    /// @brief Called when ticks are received, like `onTicks`, but \a ticks
+    ///        views a buffer owned by `ticker` and reused for every message.
+    ///        Once the buffer has grown to fit the largest message, delivering
+    ///        ticks doesn't allocate. \a ticks is only valid until the
+    ///        callback returns; copy the ticks that should outlive it.
+    ///
+    std::function<void(ticker* ws, kc::span<const kc::tick> ticks)>
+        onTicksView;
+
+    ///
+    /// @brief Called when ticks are received, with ticks decoded into
+    ///        `kc::compactTick`s. Unlike `onTicks`, decoding doesn't allocate
+    ///        once the buffer has grown to fit the largest message, but
+    ///        \a ticks is only valid until the callback returns.
+    ///
+    std::function<void(ticker* ws, const std::vector<kc::compactTick>& ticks)>
+        onCompactTicks;
+
+    ///
+    /// @brief Called when ticks are received, with ticks decoded into
+    ///        `kc::fixedTick`s. Prices are left as integers, see
+    ///        `kc::fixedTick::price()` for converting them. \a ticks is only
+    ///        valid until the callback returns.
+    ///
+    std::function<void(ticker* ws, const std::vector<kc::fixedTick>& ticks)>
+        onFixedTicks;
+
+    ///
+    /// @brief Called when ticks are received, with the ticks of a message
+    ///        stored column-wise in a `kc::tickBatch`. \a batch is reused
+    ///        for every message and is only valid until the callback returns.
+    ///
+    std::function<void(ticker* ws, const kc::tickBatch& batch)> onTickBatch;
+
     /// @brief Called when an order update is received.
     std::function<void(ticker* ws, const kc::postback& postback)> onOrderUpdate;
 
@@ -98,10 +145,28 @@ class ticker {
     ///       be used to tweak the alogrithm. MaxReconnectDelay is the
     ///       maximum delay after which subsequent reconnection interval will
     ///       become constant and MaxReconnectTries is maximum number of retries
-    ///       before `ticker` quits trying to reconnect.
+    ///       before `ticker` quits trying to reconnect. Intervals are
+    ///       randomized by up to half, and waited for with an event loop timer,
+    ///       so the loop keeps running in between.
     ///
     std::function<void(ticker* ws, unsigned int attemptCount)> onTryReconnect;
 
+    ///
+    /// @brief Called when reconnect attempt \a attemptCount is scheduled to
+    ///        happen after \a delay.
+    ///
+    std::function<void(
+        ticker* ws, unsigned int attemptCount, std::chrono::milliseconds delay)>
+        onReconnectScheduled;
+
+    ///
+    /// @brief Called when a connection is reestablished, with the number of
+    ///        attempts it took and the time since the connection was lost.
+    ///
+    std::function<void(ticker* ws, unsigned int attemptCount,
+        std::chrono::milliseconds downtime)>
+        onReconnect;
+
     ///
     /// @brief Called when reconnect attempts exceed maximum reconnect attempts
     ///        set by user i.e., when `ticker` is unable to reconnect
@@ -141,6 +206,12 @@ class ticker {
         unsigned int MaxReconnectDelay = DEFAULT_MAX_RECONNECT_DELAY,
         unsigned int MaxReconnectTries = DEFAULT_MAX_RECONNECT_TRIES);
 
+    ticker(const ticker&) = delete;
+    ticker& operator=(const ticker&) = delete;
+
+    /// @brief Destroy the ticker object. Stops the I/O thread if running.
+    ~ticker();
+
     ///
     /// @brief Set the API key.
     ///
@@ -189,12 +260,216 @@ class ticker {
     /// @brief Start the client. Should always be called after `connect()`.
     void run();
 
+    ///
+    /// @brief Get a file descriptor that an external event loop, e.g., one
+    ///        built on `epoll` or libuv's `uv_poll_t`, can watch instead of
+    ///        calling `run()`. It becomes readable when `poll()` has work to
+    ///        do. Only supported with the epoll & libuv backends of uWS.
+    ///
+    /// @paragraph ex1 example
+    /// @code
+    /// Ticker.connect();
+    /// epoll_event Event {};
+    /// Event.events = EPOLLIN;
+    /// epoll_ctl(Epoll, EPOLL_CTL_ADD, Ticker.getPollFd(), &Event);
+    /// while (...) {
+    ///     epoll_wait(Epoll, Events, MaxEvents, Ticker.getPollTimeout());
+    ///     Ticker.poll(); // and the loop's other sources
+    /// }
+    /// @endcode
+    ///
+    int getPollFd();
+
+    ///
+    /// @brief Get the time in ms after which `poll()` should be called even
+    ///        if the descriptor returned by `getPollFd()` isn't readable, so
+    ///        that timers, e.g., of pings & reconnects, fire. -1 if no timer
+    ///        is pending.
+    ///
+    int getPollTimeout();
+
+    ///
+    /// @brief Handle the events that are ready, e.g., received messages &
+    ///        expired timers, without blocking. Callbacks are called on the
+    ///        calling thread. Can't be used along with the I/O thread.
+    ///
+    void poll();
+
     /// @brief Stop the client. Closes the connection if connected. Should be
-    ///        the last method that is called.
+    ///        the last method that is called. If the I/O thread was started,
+    ///        also waits for it to exit. Shard workers, if any, are stopped
+    ///        after handling the ticks already queued for them and the
+    ///        multicast ring, if any, is closed.
     void stop();
 
     ///
-    /// @brief Subscribe to a list of instrument tokens.
+    /// @brief Start the client on a thread owned by `ticker`, instead of
+    ///        calling `run()`. Should be called after `connect()`.
+    ///
+    /// Every tick received is decoded into a `kc::compactTick` and pushed to
+    /// the tick queue returned by `getTickQueue()`, which a consumer thread
+    /// can drain at its own pace. A consumer that falls behind doesn't delay
+    /// reading the socket or replying to pings; once the queue is full,
+    /// further ticks are dropped and counted in `getTickQueueStats()`.
+    ///
+    /// Callbacks, if set, are still called on the I/O thread. Apart from
+    /// `stop()`, `post()`, subscription methods and the tick queue, `ticker`
+    /// must only be used from them while the I/O thread is running.
+    ///
+    /// @param queueCapacity minimum number of ticks the queue can hold,
+    ///                      rounded up to a power of two. No queue is created
+    ///                      if it is 0.
+    ///
+    void startIoThread(size_t queueCapacity = DEFAULT_TICK_QUEUE_CAPACITY);
+
+    ///
+    /// @brief Run \a task on the I/O thread, e.g., to subscribe while it is
+    ///        running. Can be called from any thread. If the I/O thread isn't
+    ///        running, \a task is run right away on the calling thread.
+    ///
+    /// @param task called with this `ticker`
+    ///
+    void post(std::function<void(ticker* ws)> task);
+
+    ///
+    /// @brief Get the queue ticks are pushed to when the I/O thread is
+    ///        running. It has a single consumer, i.e., only one thread should
+    ///        pop ticks at a time.
+    ///
+    /// @return kc::spscRing<kc::compactTick>& tick queue
+    ///
+    kc::spscRing<kc::compactTick>& getTickQueue();
+
+    /// @brief Get the tick queue's depth, high-water mark and drop count.
+    kc::queueStats getTickQueueStats() const;
+
+    ///
+    /// @brief Hand ticks to \a NumberOfWorkers worker threads, chosen by
+    ///        hashing the instrument token. Ticks of an instrument are always
+    ///        handled by the same worker, in order. Should be called before
+    ///        `run()` or `startIoThread()`. Workers are stopped by `stop()`.
+    ///
+    /// @param NumberOfWorkers number of worker threads
+    /// @param onShardTicks    called on worker threads with batches of
+    ///                        `kc::compactTick`s of their shard
+    /// @param queueCapacity   minimum number of ticks each worker's queue can
+    ///                        hold. Ticks are dropped once it is full.
+    /// @param cpus            if not empty, worker `i` is pinned to CPU
+    ///                        `cpus[i % cpus.size()]` (Linux only)
+    ///
+    void startShardWorkers(size_t NumberOfWorkers,
+        kc::tickShards::callback onShardTicks,
+        size_t queueCapacity = DEFAULT_TICK_QUEUE_CAPACITY,
+        const std::vector<int>& cpus = {});
+
+    /// @brief Get the queue metrics of shard worker \a shard.
+    kc::queueStats getShardStats(size_t shard) const;
+
+    ///
+    /// @brief Keep the latest tick of every instrument in a cache that any
+    ///        thread can read without locks. Should be called before `run()`
+    ///        or `startIoThread()`.
+    ///
+    /// @param maxInstruments maximum number of instruments the cache can hold
+    ///
+    void enableLastValueCache(size_t maxInstruments);
+
+    ///
+    /// @brief Get the cache enabled by `enableLastValueCache()`.
+    ///
+    /// @paragraph ex1 example
+    /// @code
+    /// kc::compactTick Tick;
+    /// if (Ticker.getLastValueCache().get(408065, Tick)) { ... }
+    /// @endcode
+    ///
+    const kc::lastValueCache& getLastValueCache() const;
+
+    ///
+    /// @brief Publish every tick to a ring read by several consumers, each on
+    ///        its own thread and with its own cursor. Ticks are decoded and
+    ///        copied once, no matter the number of consumers. Should be
+    ///        called before `run()` or `startIoThread()`.
+    ///
+    /// Consumers should be added to the returned ring before ticks arrive.
+    /// Once the slowest consumer is \a capacity ticks behind, further ticks
+    /// are dropped for every consumer and counted in the ring's `stats()`.
+    ///
+    /// @param capacity minimum number of ticks the ring can hold, rounded up
+    ///                 to a power of two
+    /// @param strategy how consumers wait for ticks
+    ///
+    /// @return kc::multicastRing& ring
+    ///
+    /// @paragraph ex1 example
+    /// @code
+    /// auto& Ring = Ticker.enableMulticast();
+    /// auto& Consumer = Ring.addConsumer();
+    /// std::thread Thread([&]() {
+    ///     while (Consumer.consume([](kc::span<const kc::compactTick> Ticks) {
+    ///         ...
+    ///     }) > 0) {};
+    /// });
+    /// @endcode
+    ///
+    kc::multicastRing& enableMulticast(
+        size_t capacity = DEFAULT_TICK_QUEUE_CAPACITY,
+        kc::WAIT_STRATEGY strategy = kc::WAIT_STRATEGY::YIELD);
+
+    ///
+    /// @brief Write every tick to the shared memory segment \a name, so that
+    ///        other processes on the machine can read them with
+    ///        `kc::shmReader` using this connection. POSIX only. Should be
+    ///        called before `run()` or `startIoThread()`. The segment is
+    ///        removed when `ticker` is destroyed.
+    ///
+    /// @param name     name of the segment, e.g., "/kite-ticks"
+    /// @param capacity minimum number of ticks the segment can hold, rounded
+    ///                 up to a power of two. Readers that fall further behind
+    ///                 lose ticks.
+    ///
+    void enableSharedMemoryBus(
+        const string& name, size_t capacity = DEFAULT_TICK_QUEUE_CAPACITY);
+
+    ///
+    /// @brief Keep the state of every order in a book that any thread can
+    ///        read without locks, updated from order updates received on the
+    ///        websocket. Should be called before `connect()`.
+    ///
+    /// @param maxOrders   maximum number of orders the book can hold
+    /// @param fetchOrders if set, called on the first successful connect to
+    ///                    load the orders placed so far. It runs on a thread
+    ///                    of its own so that it doesn't stall the loop; the
+    ///                    orders are loaded on the loop's thread once it
+    ///                    returns. It is retried on the next connect if it
+    ///                    throws, after `onError` is called. `stop()` waits
+    ///                    for it to return.
+    ///
+    /// @paragraph ex1 example
+    /// @code
+    /// Ticker.enableOrderBook(1000, [&Kite]() { return Kite.orders(); });
+    /// ...
+    /// kc::orderState Order;
+    /// if (Ticker.getOrderBook().get("220303000308932", Order)) { ... }
+    /// @endcode
+    ///
+    void enableOrderBook(size_t maxOrders,
+        std::function<std::vector<kc::order>()> fetchOrders = {});
+
+    /// @brief Get the book enabled by `enableOrderBook()`.
+    const kc::orderBook& getOrderBook() const;
+
+    ///
+    /// @brief Subscribe to a list of instrument tokens. Can be called from
+    ///        any thread; while the I/O thread is running, other threads
+    ///        block until the request is queued by it.
+    ///
+    /// Subscription changes made during a loop iteration are merged & sent
+    /// together on the next one, in frames of a limited size and at a
+    /// limited rate, see `setControlFrameLimits()`.
+    ///
+    /// Subscriptions made with this method, `unsubscribe()` & `setMode()`
+    /// belong to a default subscriber, see `addSubscriber()`.
     ///
     /// @param instrumentTokens list of instrument tokens that should be
     ///                         subscribed
@@ -202,7 +477,7 @@ class ticker {
     void subscribe(const std::vector<int>& instrumentTokens);
 
     ///
-    /// @brief Unsubscribe.
+    /// @brief Unsubscribe. Can be called from any thread, like `subscribe()`.
     ///
     /// @param instrumentTokens list of instrument tokens that should be
     ///                         unsubscribed
@@ -210,7 +485,8 @@ class ticker {
     void unsubscribe(const std::vector<int>& instrumentTokens);
 
     /**
-     * @brief Set the subscription mode for a list of instrument tokens.
+     * @brief Set the subscription mode for a list of instrument tokens. Can be
+     *        called from any thread, like `subscribe()`.
      *
      * @param mode             mode to set
      * @param instrumentTokens list of instrument tokens whose mode should be
@@ -218,32 +494,114 @@ class ticker {
      */
     void setMode(const string& mode, const std::vector<int>& instrumentTokens);
 
+    ///
+    /// @brief Register a new subscriber, e.g., for a module of the
+    ///        application, and get its ID. Can be called from any thread.
+    ///
+    /// Subscriptions are reference counted across subscribers: an instrument
+    /// stays subscribed until every subscriber that asked for it unsubscribes
+    /// and is streamed in the highest mode any of them asked for. Only the
+    /// net changes are sent to the server.
+    ///
+    /// @paragraph ex1 example
+    /// @code
+    /// const uint32_t Charts = Ticker.addSubscriber();
+    /// const uint32_t Orders = Ticker.addSubscriber();
+    /// Ticker.subscribe(Charts, { 408065 }, kc::MODE_LTP);
+    /// Ticker.subscribe(Orders, { 408065 }, kc::MODE_FULL); // now `full`
+    /// Ticker.unsubscribe(Orders, { 408065 });              // back to `ltp`
+    /// @endcode
+    ///
+    uint32_t addSubscriber();
+
+    ///
+    /// @brief Subscribe to \a instrumentTokens in \a mode on behalf of
+    ///        \a subscriber, or change the mode it asked for. Can be called
+    ///        from any thread, like `subscribe()`.
+    ///
+    /// @param subscriber       ID returned by `addSubscriber()`
+    /// @param instrumentTokens list of instrument tokens
+    /// @param mode             one of `MODE_LTP`, `MODE_QUOTE`, `MODE_FULL`
+    ///
+    void subscribe(uint32_t subscriber,
+        const std::vector<int>& instrumentTokens,
+        const string& mode = MODE_QUOTE);
+
+    ///
+    /// @brief Drop \a subscriber's subscriptions to \a instrumentTokens.
+    ///        Instruments other subscribers asked for stay subscribed. Can be
+    ///        called from any thread, like `subscribe()`.
+    ///
+    void unsubscribe(
+        uint32_t subscriber, const std::vector<int>& instrumentTokens);
+
+    /// @brief Drop every subscription of \a subscriber. Can be called from
+    ///        any thread, like `subscribe()`.
+    void removeSubscriber(uint32_t subscriber);
+
+    ///
+    /// @brief Set the limits of frames carrying subscription changes.
+    ///
+    /// @param maxTokensPerFrame  maximum number of instrument tokens per frame
+    /// @param maxFramesPerSecond maximum number of frames sent per second
+    ///
+    void setControlFrameLimits(
+        size_t maxTokensPerFrame, unsigned int maxFramesPerSecond);
+
+    ///
+    /// @brief Like `subscribe()`, but doesn't wait for the I/O thread.
+    ///
+    /// @return std::future<void> ready once the request is queued for
+    ///         sending. Holds the exception thrown, e.g., if not connected.
+    ///         Can be ignored.
+    ///
+    /// @paragraph ex1 example
+    /// @code
+    /// auto Sent = Ticker.subscribeAsync({ 408065 });
+    /// ...
+    /// Sent.get();
+    /// @endcode
+    ///
+    std::future<void> subscribeAsync(const std::vector<int>& instrumentTokens);
+
+    /// @brief Like `unsubscribe()`, but doesn't wait for the I/O thread.
+    std::future<void> unsubscribeAsync(
+        const std::vector<int>& instrumentTokens);
+
+    /// @brief Like `setMode()`, but doesn't wait for the I/O thread.
+    std::future<void> setModeAsync(
+        const string& mode, const std::vector<int>& instrumentTokens);
+
+    ///
+    /// @brief Set the fields decoded for instruments without a field mask of
+    ///        their own. Fields that aren't decoded keep their default values.
+    ///        All fields are decoded by default.
+    ///
+    /// @param fields `kc::FIELDS_*` constants or'd together, e.g.,
+    ///               `kc::FIELDS_VOLUME | kc::FIELDS_OHLC`
+    ///
+    void setFieldMask(uint32_t fields);
+
+    ///
+    /// @brief Set the fields decoded for a list of instrument tokens,
+    ///        overriding the mask set by `setFieldMask(uint32_t)`.
+    ///
+    /// @param fields           `kc::FIELDS_*` constants or'd together
+    /// @param instrumentTokens list of instrument tokens
+    ///
+    void setFieldMask(
+        uint32_t fields, const std::vector<int>& instrumentTokens);
+
   private:
     friend class tickerTest_binaryParsingTest_Test;
     const string connectUrlFmt =
         "wss://ws.kite.trade/?api_key={0}&access_token={1}";
     string key;
     string token;
-    enum class SEGMENTS : int
-    {
-        NSE = 1,
-        NFO,
-        CDS,
-        BSE,
-        BFO,
-        BSECDS,
-        MCX,
-        MCXSX,
-        INDICES
-    };
-    enum class MODES
-    {
-        LTP,
-        QUOTE,
-        FULL
-    };
-    const MODES DEFAULT_MODE = MODES::QUOTE;
-    std::unordered_map<int, MODES> subbedInstruments;
+    // owner of subscriptions made without a subscriber ID
+    static constexpr uint32_t DEFAULT_SUBSCRIBER = 0;
+    std::atomic<uint32_t> lastSubscriber { DEFAULT_SUBSCRIBER };
+    internal::subscriberRegistry subbedInstruments;
     uWS::Hub hub;
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
     uWS::Group<uWS::CLIENT>* group;
@@ -252,34 +610,91 @@ class ticker {
     static constexpr unsigned int DEFAULT_CONNECT_TIMEOUT = 5;      // s
     static constexpr unsigned int DEFAULT_MAX_RECONNECT_DELAY = 60; // s
     static constexpr unsigned int DEFAULT_MAX_RECONNECT_TRIES = 30;
+    static constexpr size_t DEFAULT_TICK_QUEUE_CAPACITY = 65536;
     const unsigned int connectTimeout = DEFAULT_CONNECT_TIMEOUT; // ms
     const string pingMessage;
     const unsigned int pingInterval = 3000; // ms
     const bool enableReconnect = false;
     const unsigned int initReconnectDelay = 2; // s
-    unsigned int reconnectDelay = initReconnectDelay;
     const unsigned int maxReconnectDelay = DEFAULT_MAX_RECONNECT_DELAY; // s
     unsigned int reconnectTries = 0;
     const unsigned int maxReconnectTries = DEFAULT_MAX_RECONNECT_TRIES;
     std::atomic<bool> isReconnecting { false };
+    // when the connection being reestablished was lost
+    std::chrono::steady_clock::time_point disconnectTime;
+    // pending reconnect attempt, freed by the loop once closed
+    uS::Timer* reconnectTimer = nullptr;
+    // outgoing subscription changes
+    internal::controlQueue control;
+    // pending flush of `control`, freed by the loop once closed
+    uS::Timer* controlTimer = nullptr;
+    std::mt19937 reconnectJitter { std::random_device()() };
     std::chrono::time_point<std::chrono::system_clock> lastPongTime;
     std::chrono::time_point<std::chrono::system_clock> lastBeatTime;
+    std::vector<kc::tick> ticks;
+    std::vector<kc::compactTick> compactTicks;
+    std::vector<kc::fixedTick> fixedTicks;
+    kc::tickBatch batch;
+    internal::binary::fieldMasks fieldMasks;
+    internal::textMessageParser textMessages;
+    std::unique_ptr<kc::spscRing<kc::compactTick>> tickQueue;
+    std::unique_ptr<kc::tickShards> shards;
+    std::unique_ptr<kc::lastValueCache> lastValues;
+    std::unique_ptr<kc::multicastRing> multicast;
+    std::unique_ptr<kc::shmPublisher> shmBus;
+    std::unique_ptr<kc::orderBook> orderStates;
+    // loads `orderStates` once connected, reset once it succeeded
+    std::function<std::vector<kc::order>()> fetchOrders;
+    // runs `fetchOrders` off the loop
+    std::thread ordersFetcher;
+    // set until the loop takes the fetcher's result
+    std::atomic<bool> isFetchingOrders { false };
+    // loads the fetched orders or reports why fetching failed
+    std::mutex fetchedMutex;
+    std::function<void(ticker* ws)> fetchedOrders;
+    std::atomic<bool> hasFetchedOrders { false };
+    std::thread ioThread;
+    // posted to by `stop()` to stop the I/O thread's loop from another thread
+    std::atomic<uS::Async*> stopAsync { nullptr };
+    // runs tasks passed to `post()` on the I/O thread
+    std::mutex tasksMutex;
+    std::vector<std::function<void(ticker* ws)>> tasks;
+    uS::Async* tasksAsync = nullptr;
 
     void connectInternal();
 
+    void stopInternal();
+
     void reconnect();
 
-    void processTextMessage(const string& message);
+    void cancelReconnect();
+
+    void scheduleControl(std::chrono::milliseconds delay);
+
+    void cancelControl();
 
-    template <typename T>
-    T unpack(const std::vector<char>& bytes, size_t start, size_t end);
+    void flushControl();
 
-    std::vector<std::vector<char>> splitPackets(const std::vector<char>& bytes);
+    void sendChanges(const internal::subscriptionChanges& changes);
 
-    std::vector<kc::tick> parseBinaryMessage(char* bytes, size_t size);
+    void processTextMessage(const char* message, size_t length);
+
+    void processBinaryMessage(const char* bytes, size_t size);
+
+    void runTasks();
+
+    bool isOffIoThread() const;
+
+    std::future<void> postCommand(std::function<void(ticker* ws)> command);
+
+    std::vector<kc::tick> parseBinaryMessage(const char* bytes, size_t size);
 
     void resubInstruments();
 
+    void loadOrders();
+
+    void applyFetchedOrders();
+
     void assignCallbacks();
 };
 } // namespace kiteconnect
\ No newline at end of file
@@ -30,6 +30,7 @@
  * @brief Useful constants users can utilize.
  */
 
+#include <cstdint>
 #include <string>
 
 namespace kiteconnect {
@@ -101,5 +102,16 @@ const string MODE_LTP = "ltp";
 const string MODE_QUOTE = "quote";
 const string MODE_FULL = "full";
 
+// ticker field masks. Last price, instrument token & mode are always decoded.
+constexpr uint32_t FIELDS_LTP = 0;
+constexpr uint32_t FIELDS_VOLUME = 1U << 0U;
+constexpr uint32_t FIELDS_QUOTE = 1U << 1U; // ltq, atp, total buy & sell
+constexpr uint32_t FIELDS_OHLC = 1U << 2U;  // ohlc & net change
+constexpr uint32_t FIELDS_OI = 1U << 3U;
+constexpr uint32_t FIELDS_TIMESTAMPS = 1U << 4U;
+constexpr uint32_t FIELDS_DEPTH = 1U << 5U;
+constexpr uint32_t FIELDS_ALL = FIELDS_VOLUME | FIELDS_QUOTE | FIELDS_OHLC |
+                                FIELDS_OI | FIELDS_TIMESTAMPS | FIELDS_DEPTH;
+
 // NOLINTEND(cert-err58-cpp)
 } // namespace kiteconnect
@@ -25,6 +25,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -564,6 +566,29 @@ const unsigned int NORMAL_CLOSURE = 1000;
 const unsigned int NO_REASON = 1006;
 } // namespace ws::ERROR_CODE
 
+namespace ws {
+///
+/// @brief Delay before reconnect attempt \a attempt (starting at 1). Doubles
+///        with every attempt up to \a maxDelay. Only half of it is fixed, the
+///        rest is scaled by \a jitter so that clients disconnected together
+///        don't reconnect in lockstep.
+///
+/// @param jitter random number in [0, 1)
+///
+inline std::chrono::milliseconds reconnectDelay(unsigned int attempt,
+    std::chrono::milliseconds initialDelay, std::chrono::milliseconds maxDelay,
+    double jitter) {
+    std::chrono::milliseconds delay = initialDelay;
+    for (unsigned int i = 1; i < attempt && delay < maxDelay; i++) {
+        delay *= 2;
+    };
+    delay = std::min(delay, maxDelay);
+    const auto half = delay / 2;
+    return half + std::chrono::milliseconds(static_cast<int64_t>(
+                      static_cast<double>((delay - half).count()) * jitter));
+};
+} // namespace ws
+
 template <class Param>
 void addParam(http::Params& bodyParams, Param& param, const string& fieldName) {
     static_assert(
@@ -0,0 +1,467 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "kitepp/ticker/cache.hpp"
+#include "kitepp/ticker/encoder.hpp"
+#include "kitepp/ticker/multicast.hpp"
+#include "kitepp/ticker/parser.hpp"
+#include "kitepp/ticker/postback.hpp"
+#include "kitepp/ticker/ring.hpp"
+
+namespace {
+
+namespace kc = kiteconnect;
+namespace binary = kc::internal::binary;
+
+// counts every heap allocation made by the process
+std::atomic<size_t> allocations { 0 };
+
+// builds a frame of `numberOfPackets` packets by cycling through the packets
+// of the sample message. Packets are cut down to `packetSize` bytes to emulate
+// smaller modes.
+std::vector<char> makeFrame(size_t numberOfPackets,
+    size_t packetSize = binary::layout::full::SIZE) {
+    std::ifstream dataFile("../tests/mock_custom/websocket_ticks.bin");
+    const std::vector<char> sample(
+        std::istreambuf_iterator<char>(dataFile), {});
+    if (sample.empty()) {
+        std::cerr << "couldn't read tests/mock_custom/websocket_ticks.bin, "
+                     "run the benchmarks from the build directory\n";
+        std::abort();
+    };
+    std::vector<binary::packetView> packets;
+    for (const auto& packet : binary::frameView(sample.data(), sample.size())) {
+        packets.push_back(packet);
+    };
+
+    std::vector<char> frame;
+    const auto appendLength = [&frame](size_t length) {
+        frame.push_back(static_cast<char>((length >> 8) & 0xff));
+        frame.push_back(static_cast<char>(length & 0xff));
+    };
+    appendLength(numberOfPackets);
+    for (size_t i = 0; i < numberOfPackets; i++) {
+        const auto& packet = packets[i % packets.size()];
+        appendLength(packetSize);
+        frame.insert(frame.end(), packet.data(), packet.data() + packetSize);
+    };
+    return frame;
+};
+
+void setCounters(benchmark::State& state, size_t allocationsBefore) {
+    const auto numberOfPackets = static_cast<int64_t>(state.range(0));
+    state.SetItemsProcessed(state.iterations() * numberOfPackets);
+    state.counters["time/packet"] =
+        benchmark::Counter(static_cast<double>(numberOfPackets),
+            benchmark::Counter::kIsIterationInvariantRate |
+                benchmark::Counter::kInvert);
+    state.counters["allocs/frame"] = benchmark::Counter(
+        static_cast<double>(allocations - allocationsBefore),
+        benchmark::Counter::kAvgIterations);
+};
+
+// field decoding as done before big-endian loads, kept as a baseline
+template <typename T>
+T legacyUnpack(const std::vector<char>& bytes, size_t start, size_t end) {
+    T value;
+    std::vector<char> requiredBytes(bytes.begin() + static_cast<int64_t>(start),
+        bytes.begin() + static_cast<int64_t>(end) + 1);
+    std::reverse(requiredBytes.begin(), requiredBytes.end());
+    std::memcpy(&value, requiredBytes.data(), sizeof(T));
+    return value;
+};
+
+void BM_legacyUnpack(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacyUnpack<int32_t>(frame, 4, 7));
+    };
+};
+BENCHMARK(BM_legacyUnpack);
+
+void BM_unpack(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(1);
+    const char* field = frame.data() + 4;
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        benchmark::DoNotOptimize(binary::unpack<int32_t>(field));
+    };
+};
+BENCHMARK(BM_unpack);
+
+void BM_walkPackets(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(state.range(0));
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        int64_t sum = 0;
+        const binary::frameView view(frame.data(), frame.size());
+        for (const auto& packet : view) { sum += packet.get<int32_t>(0); };
+        benchmark::DoNotOptimize(sum);
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_walkPackets)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+// decodes into the same tick every time, measuring decoding alone
+void BM_parsePacket(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(1, state.range(0));
+    const binary::frameView view(frame.data(), frame.size());
+    const binary::packetView packet = *view.begin();
+    kc::tick Tick;
+    for (auto _ : state) {
+        binary::parsePacket(packet, Tick);
+        benchmark::DoNotOptimize(Tick);
+    };
+    state.SetItemsProcessed(state.iterations());
+};
+BENCHMARK(BM_parsePacket)
+    ->Arg(binary::layout::ltp::SIZE)
+    ->Arg(binary::layout::indicesQuote::SIZE)
+    ->Arg(binary::layout::indicesFull::SIZE)
+    ->Arg(binary::layout::quote::SIZE)
+    ->Arg(binary::layout::full::SIZE);
+
+// like BM_parsePacket, but only decodes the fields in the second argument
+void BM_parsePacketFields(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(1, state.range(0));
+    const binary::frameView view(frame.data(), frame.size());
+    const binary::packetView packet = *view.begin();
+    binary::fieldMasks masks;
+    masks.defaultFields = static_cast<uint32_t>(state.range(1));
+    kc::tick Tick;
+    for (auto _ : state) {
+        binary::parsePacket(packet, Tick, masks);
+        benchmark::DoNotOptimize(Tick);
+    };
+    state.SetItemsProcessed(state.iterations());
+};
+BENCHMARK(BM_parsePacketFields)
+    ->ArgNames({ "size", "fields" })
+    ->ArgsProduct({ { binary::layout::ltp::SIZE, binary::layout::quote::SIZE,
+                        binary::layout::full::SIZE },
+        { kc::FIELDS_LTP, kc::FIELDS_VOLUME,
+            kc::FIELDS_VOLUME | kc::FIELDS_OHLC, kc::FIELDS_ALL } });
+
+template <binary::quoteHeaderDecoder decodeQuoteHeader,
+    binary::depthDecoder decodeDepth>
+void BM_decodeFullPacket(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(1);
+    const binary::frameView view(frame.data(), frame.size());
+    const binary::packetView packet = *view.begin();
+    binary::quoteHeader header;
+    std::array<kc::depthWS, binary::layout::full::DEPTH_ENTRIES> depth;
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        decodeQuoteHeader(packet.data(), 100.0, header);
+        decodeDepth(packet.data() + binary::layout::full::DEPTH, 100.0,
+            depth.data(), depth.data() + depth.size() / 2);
+        benchmark::DoNotOptimize(header);
+        benchmark::DoNotOptimize(depth);
+    };
+    state.SetItemsProcessed(state.iterations());
+};
+BENCHMARK_TEMPLATE(BM_decodeFullPacket, binary::scalar::decodeQuoteHeader,
+    binary::scalar::decodeDepth);
+#ifdef KITEPP_X86_SIMD
+BENCHMARK_TEMPLATE(BM_decodeFullPacket, binary::ssse3::decodeQuoteHeader,
+    binary::ssse3::decodeDepth);
+BENCHMARK_TEMPLATE(BM_decodeFullPacket, binary::avx2::decodeQuoteHeader,
+    binary::avx2::decodeDepth);
+#endif
+
+void BM_parseBinaryMessage(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(state.range(0));
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(binary::parse(frame.data(), frame.size()));
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseBinaryMessage)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+void BM_parseIntoTickBuffer(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(state.range(0));
+    std::vector<kc::tick> buffer;
+    binary::parseInto(frame.data(), frame.size(), buffer);
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            binary::parseInto(frame.data(), frame.size(), buffer));
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseIntoTickBuffer)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+void BM_parseCompactTicks(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(state.range(0));
+    std::vector<kc::compactTick> ticks;
+    binary::parse(frame.data(), frame.size(), ticks);
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        binary::parse(frame.data(), frame.size(), ticks);
+        benchmark::DoNotOptimize(ticks.data());
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseCompactTicks)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+void BM_parseTickBatch(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(state.range(0));
+    kc::tickBatch batch;
+    binary::parse(frame.data(), frame.size(), batch);
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        binary::parse(frame.data(), frame.size(), batch);
+        benchmark::DoNotOptimize(batch.lastPrice.data());
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseTickBatch)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+void BM_parseFixedTicks(benchmark::State& state) {
+    const std::vector<char> frame = makeFrame(state.range(0));
+    std::vector<kc::fixedTick> ticks;
+    binary::parse(frame.data(), frame.size(), ticks);
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        binary::parse(frame.data(), frame.size(), ticks);
+        benchmark::DoNotOptimize(ticks.data());
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseFixedTicks)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+// decodes frames mixing every mode & segment with each tick type
+template <class Tick>
+void BM_parseMixedFrame(benchmark::State& state) {
+    const std::vector<char> frame =
+        binary::frameGenerator().next(state.range(0));
+    std::vector<Tick> ticks;
+    binary::parseInto(frame.data(), frame.size(), ticks);
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            binary::parseInto(frame.data(), frame.size(), ticks));
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK_TEMPLATE(BM_parseMixedFrame, kc::tick)
+    ->Arg(1)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(3000);
+BENCHMARK_TEMPLATE(BM_parseMixedFrame, kc::compactTick)
+    ->Arg(1)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(3000);
+BENCHMARK_TEMPLATE(BM_parseMixedFrame, kc::fixedTick)
+    ->Arg(1)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(3000);
+
+void BM_generateFrame(benchmark::State& state) {
+    binary::frameGenerator generator;
+    generator.next(state.range(0));
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.next(state.range(0)).data());
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_generateFrame)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+void BM_encodeFrame(benchmark::State& state) {
+    const std::vector<char> source =
+        binary::frameGenerator().next(state.range(0));
+    std::vector<kc::compactTick> ticks;
+    binary::parse(source.data(), source.size(), ticks);
+    std::vector<char> frame;
+    binary::encode(kc::span<const kc::compactTick>(ticks), frame);
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        binary::encode(kc::span<const kc::compactTick>(ticks), frame);
+        benchmark::DoNotOptimize(frame.data());
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_encodeFrame)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+// round trip of a frame's ticks through the I/O thread's queue
+void BM_tickQueue(benchmark::State& state) {
+    const std::vector<char> frame =
+        binary::frameGenerator().next(state.range(0));
+    std::vector<kc::compactTick> ticks;
+    binary::parse(frame.data(), frame.size(), ticks);
+    std::vector<kc::compactTick> popped(ticks.size());
+    kc::spscRing<kc::compactTick> queue(ticks.size());
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        queue.tryPush(kc::span<const kc::compactTick>(ticks));
+        benchmark::DoNotOptimize(queue.tryPop(popped.data(), popped.size()));
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_tickQueue)->Arg(1)->Arg(100)->Arg(1000)->Arg(3000);
+
+// a frame's ticks published once & read in place by every consumer
+void BM_multicastRing(benchmark::State& state) {
+    const std::vector<char> frame =
+        binary::frameGenerator().next(state.range(0));
+    std::vector<kc::compactTick> ticks;
+    binary::parse(frame.data(), frame.size(), ticks);
+    kc::multicastRing ring(ticks.size());
+    std::vector<kc::multicastRing::consumer*> consumers;
+    for (int64_t i = 0; i < state.range(1); i++) {
+        consumers.push_back(&ring.addConsumer());
+    };
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        ring.publish(kc::span<const kc::compactTick>(ticks));
+        for (auto* consumer : consumers) {
+            consumer->tryConsume([](kc::span<const kc::compactTick> batch) {
+                benchmark::DoNotOptimize(batch.back().lastPrice);
+            });
+        };
+    };
+    setCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_multicastRing)->ArgsProduct({ { 1, 100, 1000 }, { 1, 4 } });
+
+// thread 0 keeps updating the cache while the other threads read from it
+void BM_lastValueCache(benchmark::State& state) {
+    constexpr size_t numberOfInstruments = 1000;
+    static std::unique_ptr<kc::lastValueCache> cache;
+    static std::vector<kc::compactTick> ticks;
+    if (state.thread_index() == 0) {
+        const std::vector<char> frame =
+            binary::frameGenerator().next(numberOfInstruments);
+        binary::parse(frame.data(), frame.size(), ticks);
+        cache = std::make_unique<kc::lastValueCache>(numberOfInstruments);
+        cache->update(kc::span<const kc::compactTick>(ticks));
+    };
+
+    size_t idx = static_cast<size_t>(state.thread_index());
+    kc::compactTick Tick;
+    for (auto _ : state) {
+        idx = (idx + 1) % ticks.size();
+        if (state.thread_index() == 0) {
+            cache->update(ticks[idx]);
+        } else {
+            benchmark::DoNotOptimize(
+                cache->get(ticks[idx].instrumentToken, Tick));
+        };
+    };
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.thread_index() == 0 ? "writer" : "reader");
+};
+BENCHMARK(BM_lastValueCache)->ThreadRange(1, 8)->UseRealTime();
+
+// an order update as sent on the websocket
+const std::string orderUpdate =
+    R"({"type":"order","data":{"account_id":"AB1234","unfilled_quantity":0,)"
+    R"("checksum":"","placed_by":"AB1234","order_id":"220303000308932",)"
+    R"("exchange_order_id":"1000000001482421","parent_order_id":null,)"
+    R"("status":"COMPLETE","status_message":null,"status_message_raw":null,)"
+    R"("order_timestamp":"2022-03-03 09:24:25",)"
+    R"("exchange_update_timestamp":"2022-03-03 09:24:25",)"
+    R"("exchange_timestamp":"2022-03-03 09:24:25","variety":"regular",)"
+    R"("exchange":"NSE","tradingsymbol":"SBIN","instrument_token":779521,)"
+    R"("order_type":"MARKET","transaction_type":"BUY","validity":"DAY",)"
+    R"("product":"CNC","quantity":1,"disclosed_quantity":0,"price":0,)"
+    R"("trigger_price":0,"average_price":470,"filled_quantity":1,)"
+    R"("pending_quantity":0,"cancelled_quantity":0,"market_protection":0,)"
+    R"("meta":{},"tag":null,"guid":"XXXXXX"}})";
+
+void setMessageCounters(benchmark::State& state, size_t allocationsBefore) {
+    state.SetItemsProcessed(state.iterations());
+    state.counters["allocs/message"] = benchmark::Counter(
+        static_cast<double>(allocations - allocationsBefore),
+        benchmark::Counter::kAvgIterations);
+};
+
+// the DOM based path order updates took before `textMessageParser`
+void BM_parseOrderUpdateDom(benchmark::State& state) {
+    namespace utils = kc::internal::utils;
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        const std::string message(orderUpdate.data(), orderUpdate.size());
+        rapidjson::Document res;
+        utils::json::parse(res, message);
+        const kc::postback Postback(utils::json::extractObject(res));
+        benchmark::DoNotOptimize(Postback.filledQuantity);
+    };
+    setMessageCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseOrderUpdateDom);
+
+void BM_parseOrderUpdateSax(benchmark::State& state) {
+    kc::internal::textMessageParser parser;
+    const size_t allocationsBefore = allocations;
+    for (auto _ : state) {
+        parser.parse(orderUpdate.data(), orderUpdate.size());
+        benchmark::DoNotOptimize(parser.getPostback().filledQuantity);
+    };
+    setMessageCounters(state, allocationsBefore);
+};
+BENCHMARK(BM_parseOrderUpdateSax);
+
+} // namespace
+
+// GCC can't tell that these replace the global allocation functions
+// clang-format off
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+// clang-format on
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* ptr = std::malloc(size)) { return ptr; };
+    throw std::bad_alloc();
+};
+
+void operator delete(void* ptr) noexcept { std::free(ptr); };
+
+void operator delete(void* ptr, size_t /*size*/) noexcept { std::free(ptr); };
+
+BENCHMARK_MAIN();
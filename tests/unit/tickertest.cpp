@@ -23,23 +23,39 @@
  * USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <future>
 #include <iterator>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "kitepp.hpp"
 
+#if defined(KITEPP_HAS_SHM)
+#include <unistd.h>
+#endif
+
 namespace kiteconnect {
 
 namespace kc = kiteconnect;
 
+// sample websocket frame of ticks, empty if it couldn't be read
+std::vector<char> loadSampleFrame() {
+    std::ifstream dataFile("../tests/mock_custom/websocket_ticks.bin");
+    return std::vector<char>(std::istreambuf_iterator<char>(dataFile), {});
+};
+
 TEST(tickerTest, binaryParsingTest) {
     kc::ticker Ticker("apikey123");
-    std::ifstream dataFile("../tests/mock_custom/websocket_ticks.bin");
-    ASSERT_TRUE(dataFile);
-    std::vector<char> data(std::istreambuf_iterator<char>(dataFile), {});
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
 
     std::vector<kc::tick> ticks =
         Ticker.parseBinaryMessage(data.data(), data.size());
@@ -169,4 +185,1074 @@ TEST(tickerTest, binaryParsingTest) {
     EXPECT_EQ(tick2.marketDepth.sell[4].quantity, 670);
     EXPECT_EQ(tick2.marketDepth.sell[4].orders, 1);
 };
+
+TEST(tickerTest, truncatedBinaryMessageTest) {
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    EXPECT_THROW(kc::internal::binary::parse(data.data(), 1), kc::libException);
+    EXPECT_THROW(kc::internal::binary::parse(data.data(), data.size() - 1),
+        kc::libException);
+};
+
+TEST(tickerTest, reusedTickBufferTest) {
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+    // 1 packet, 8 bytes long: LTP of token 408065 at 1299.05
+    const std::vector<char> ltpData = { 0, 1, 0, 8, 0, 6, 58, 1, 0, 1, -5,
+        113 };
+
+    std::vector<kc::tick> buffer;
+    ASSERT_EQ(
+        kc::internal::binary::parseInto(data.data(), data.size(), buffer), 2);
+    const kc::depthWS* depth = buffer[0].marketDepth.buy.data();
+    EXPECT_EQ(buffer[1].marketDepth.sell.size(), 5);
+
+    ASSERT_EQ(kc::internal::binary::parseInto(
+                  ltpData.data(), ltpData.size(), buffer),
+        1);
+    ASSERT_EQ(buffer.size(), 2);
+    const kc::span<const kc::tick> ticks(buffer, 1);
+    ASSERT_EQ(ticks.size(), 1);
+    const kc::tick& Tick = ticks.front();
+    EXPECT_EQ(Tick.mode, "ltp");
+    EXPECT_EQ(Tick.instrumentToken, 408065);
+    EXPECT_DOUBLE_EQ(Tick.lastPrice, 1299.05);
+    EXPECT_EQ(Tick.volumeTraded, -1);
+    EXPECT_DOUBLE_EQ(Tick.ohlc.close, -1);
+    EXPECT_TRUE(Tick.marketDepth.buy.empty());
+    EXPECT_TRUE(Tick.marketDepth.sell.empty());
+
+    // depth vectors keep their storage across messages
+    kc::internal::binary::parseInto(data.data(), data.size(), buffer);
+    EXPECT_EQ(buffer[0].marketDepth.buy.data(), depth);
+};
+
+TEST(tickerTest, compactTicksTest) {
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    const std::vector<kc::tick> ticks =
+        kc::internal::binary::parse(data.data(), data.size());
+    std::vector<kc::compactTick> compactTicks(7);
+    kc::internal::binary::parse(data.data(), data.size(), compactTicks);
+    ASSERT_EQ(compactTicks.size(), ticks.size());
+
+    for (size_t i = 0; i < ticks.size(); i++) {
+        const kc::tick& expected = ticks[i];
+        const kc::compactTick& Tick = compactTicks[i];
+        EXPECT_EQ(Tick.mode, kc::TICK_MODE::FULL);
+        EXPECT_EQ(Tick.instrumentToken, expected.instrumentToken);
+        EXPECT_EQ(Tick.isTradable, expected.isTradable);
+        EXPECT_EQ(Tick.timestamp, expected.timestamp);
+        EXPECT_EQ(Tick.lastTradeTime, expected.lastTradeTime);
+        EXPECT_DOUBLE_EQ(Tick.lastPrice, expected.lastPrice);
+        EXPECT_EQ(Tick.lastTradedQuantity, expected.lastTradedQuantity);
+        EXPECT_EQ(Tick.totalBuyQuantity, expected.totalBuyQuantity);
+        EXPECT_EQ(Tick.totalSellQuantity, expected.totalSellQuantity);
+        EXPECT_EQ(Tick.volumeTraded, expected.volumeTraded);
+        EXPECT_DOUBLE_EQ(Tick.averageTradePrice, expected.averageTradePrice);
+        EXPECT_EQ(Tick.oi, expected.oi);
+        EXPECT_EQ(Tick.oiDayHigh, expected.oiDayHigh);
+        EXPECT_EQ(Tick.oiDayLow, expected.oiDayLow);
+        EXPECT_DOUBLE_EQ(Tick.netChange, expected.netChange);
+        EXPECT_DOUBLE_EQ(Tick.ohlc.open, expected.ohlc.open);
+        EXPECT_DOUBLE_EQ(Tick.ohlc.high, expected.ohlc.high);
+        EXPECT_DOUBLE_EQ(Tick.ohlc.low, expected.ohlc.low);
+        EXPECT_DOUBLE_EQ(Tick.ohlc.close, expected.ohlc.close);
+        for (size_t j = 0; j < kc::compactTick::DEPTH_ENTRIES_PER_SIDE; j++) {
+            EXPECT_EQ(Tick.marketDepth.buy[j].quantity,
+                expected.marketDepth.buy[j].quantity);
+            EXPECT_DOUBLE_EQ(Tick.marketDepth.buy[j].price,
+                expected.marketDepth.buy[j].price);
+            EXPECT_EQ(Tick.marketDepth.buy[j].orders,
+                expected.marketDepth.buy[j].orders);
+            EXPECT_EQ(Tick.marketDepth.sell[j].quantity,
+                expected.marketDepth.sell[j].quantity);
+            EXPECT_DOUBLE_EQ(Tick.marketDepth.sell[j].price,
+                expected.marketDepth.sell[j].price);
+            EXPECT_EQ(Tick.marketDepth.sell[j].orders,
+                expected.marketDepth.sell[j].orders);
+        };
+    };
+};
+
+TEST(tickerTest, tickBatchTest) {
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    const std::vector<kc::tick> ticks =
+        kc::internal::binary::parse(data.data(), data.size());
+    kc::tickBatch batch;
+    kc::internal::binary::parse(data.data(), data.size(), batch);
+    ASSERT_EQ(batch.size(), ticks.size());
+    batch.forEachColumn(
+        [&](const auto& column) { EXPECT_EQ(column.size(), ticks.size()); });
+
+    for (size_t i = 0; i < ticks.size(); i++) {
+        const kc::tick& expected = ticks[i];
+        EXPECT_EQ(batch.instrumentToken[i], expected.instrumentToken);
+        EXPECT_EQ(batch.mode[i], kc::TICK_MODE::FULL);
+        EXPECT_EQ(batch.isTradable[i], expected.isTradable);
+        EXPECT_DOUBLE_EQ(batch.lastPrice[i], expected.lastPrice);
+        EXPECT_EQ(batch.volumeTraded[i], expected.volumeTraded);
+        EXPECT_EQ(batch.oi[i], expected.oi);
+        EXPECT_EQ(batch.timestamp[i], expected.timestamp);
+        EXPECT_EQ(batch.lastTradeTime[i], expected.lastTradeTime);
+        EXPECT_DOUBLE_EQ(batch.close[i], expected.ohlc.close);
+        for (size_t level = 0; level < kc::tickBatch::DEPTH_ENTRIES_PER_SIDE;
+             level++) {
+            EXPECT_DOUBLE_EQ(batch.buyPrice[level][i],
+                expected.marketDepth.buy[level].price);
+            EXPECT_EQ(batch.buyQuantity[level][i],
+                expected.marketDepth.buy[level].quantity);
+            EXPECT_EQ(batch.sellOrders[level][i],
+                expected.marketDepth.sell[level].orders);
+        };
+    };
+};
+
+TEST(tickerTest, fixedTicksTest) {
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    const std::vector<kc::tick> ticks =
+        kc::internal::binary::parse(data.data(), data.size());
+    std::vector<kc::fixedTick> fixedTicks;
+    kc::internal::binary::parse(data.data(), data.size(), fixedTicks);
+    ASSERT_EQ(fixedTicks.size(), ticks.size());
+
+    // tick 1
+    const kc::fixedTick& tick1 = fixedTicks[0];
+    EXPECT_EQ(tick1.mode, kc::TICK_MODE::FULL);
+    EXPECT_EQ(tick1.priceExponent, -2);
+    EXPECT_EQ(tick1.lastPrice, 129905);
+    EXPECT_EQ(tick1.averageTradePrice, 129029);
+    EXPECT_EQ(tick1.marketDepth.buy[0].price, 129900);
+    EXPECT_EQ(tick1.marketDepth.sell[4].price, 129950);
+    EXPECT_EQ(tick1.netChange, 129905 - 127210);
+    EXPECT_DOUBLE_EQ(tick1.price(tick1.lastPrice), 1299.05);
+
+    for (size_t i = 0; i < ticks.size(); i++) {
+        const kc::tick& expected = ticks[i];
+        const kc::fixedTick& Tick = fixedTicks[i];
+        EXPECT_EQ(Tick.instrumentToken, expected.instrumentToken);
+        EXPECT_EQ(Tick.volumeTraded, expected.volumeTraded);
+        EXPECT_EQ(Tick.oi, expected.oi);
+        EXPECT_DOUBLE_EQ(Tick.price(Tick.lastPrice), expected.lastPrice);
+        EXPECT_DOUBLE_EQ(
+            Tick.price(Tick.averageTradePrice), expected.averageTradePrice);
+        EXPECT_DOUBLE_EQ(Tick.price(Tick.ohlc.open), expected.ohlc.open);
+        EXPECT_DOUBLE_EQ(Tick.price(Tick.ohlc.high), expected.ohlc.high);
+        EXPECT_DOUBLE_EQ(Tick.price(Tick.ohlc.low), expected.ohlc.low);
+        EXPECT_DOUBLE_EQ(Tick.price(Tick.ohlc.close), expected.ohlc.close);
+        // computed from exact prices, unlike the legacy percentage
+        EXPECT_NEAR(Tick.netChangePercent(), expected.netChange, 1e-9);
+        for (size_t j = 0; j < kc::fixedTick::DEPTH_ENTRIES_PER_SIDE; j++) {
+            EXPECT_DOUBLE_EQ(Tick.price(Tick.marketDepth.buy[j].price),
+                expected.marketDepth.buy[j].price);
+            EXPECT_EQ(Tick.marketDepth.buy[j].quantity,
+                expected.marketDepth.buy[j].quantity);
+            EXPECT_DOUBLE_EQ(Tick.price(Tick.marketDepth.sell[j].price),
+                expected.marketDepth.sell[j].price);
+            EXPECT_EQ(Tick.marketDepth.sell[j].orders,
+                expected.marketDepth.sell[j].orders);
+        };
+    };
+};
+
+TEST(tickerTest, fieldMasksTest) {
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    kc::internal::binary::fieldMasks masks;
+    masks.defaultFields = kc::FIELDS_VOLUME;
+    masks.set(2953217, kc::FIELDS_OHLC | kc::FIELDS_DEPTH);
+    std::vector<kc::tick> ticks;
+    kc::internal::binary::parse(data.data(), data.size(), ticks, masks);
+    ASSERT_EQ(ticks.size(), 2);
+
+    const kc::tick& tick1 = ticks[0];
+    EXPECT_EQ(tick1.mode, "full");
+    EXPECT_EQ(tick1.instrumentToken, 408065);
+    EXPECT_DOUBLE_EQ(tick1.lastPrice, 1299.05);
+    EXPECT_EQ(tick1.volumeTraded, 6065675);
+    EXPECT_EQ(tick1.lastTradedQuantity, -1);
+    EXPECT_EQ(tick1.timestamp, -1);
+    EXPECT_DOUBLE_EQ(tick1.ohlc.close, -1);
+    EXPECT_TRUE(tick1.marketDepth.buy.empty());
+
+    const kc::tick& tick2 = ticks[1];
+    EXPECT_EQ(tick2.instrumentToken, 2953217);
+    EXPECT_DOUBLE_EQ(tick2.lastPrice, 3209.40);
+    EXPECT_EQ(tick2.volumeTraded, -1);
+    EXPECT_EQ(tick2.oi, -1);
+    EXPECT_DOUBLE_EQ(tick2.ohlc.close, 3157.95);
+    EXPECT_DOUBLE_EQ(tick2.netChange, 1.6292214886239578);
+    ASSERT_EQ(tick2.marketDepth.sell.size(), 5);
+    EXPECT_EQ(tick2.marketDepth.sell[4].quantity, 670);
+};
+
+TEST(tickerTest, encoderTest) {
+    namespace binary = kc::internal::binary;
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    EXPECT_EQ(binary::encode(binary::parse(data.data(), data.size())), data);
+
+    binary::frameGenerator generator;
+    for (size_t i = 0; i < 10; i++) {
+        const std::vector<char> frame = generator.next(100);
+        EXPECT_EQ(binary::encode(binary::parse(frame.data(), frame.size())),
+            frame);
+        std::vector<kc::compactTick> compactTicks;
+        binary::parse(frame.data(), frame.size(), compactTicks);
+        EXPECT_EQ(binary::encode(compactTicks), frame);
+        std::vector<kc::fixedTick> fixedTicks;
+        binary::parse(frame.data(), frame.size(), fixedTicks);
+        EXPECT_EQ(binary::encode(fixedTicks), frame);
+    };
+
+    EXPECT_NE(binary::frameGenerator(1).next(100),
+        binary::frameGenerator(2).next(100));
+};
+
+TEST(tickerTest, spscRingTest) {
+    kc::spscRing<int> ring(3);
+    EXPECT_EQ(ring.getCapacity(), 4);
+    EXPECT_TRUE(ring.empty());
+
+    const std::vector<int> values = { 1, 2, 3, 4, 5, 6 };
+    EXPECT_EQ(ring.tryPush(kc::span<const int>(values)), 4);
+    EXPECT_FALSE(ring.tryPush(7));
+    int value = 0;
+    ASSERT_TRUE(ring.tryPop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(ring.tryPush(8));
+
+    kc::queueStats stats = ring.stats();
+    EXPECT_EQ(stats.capacity, 4);
+    EXPECT_EQ(stats.depth, 4);
+    EXPECT_EQ(stats.highWaterMark, 4);
+    EXPECT_EQ(stats.pushed, 5);
+    EXPECT_EQ(stats.dropped, 3);
+
+    std::vector<int> popped(8);
+    ASSERT_EQ(ring.tryPop(popped.data(), popped.size()), 4);
+    popped.resize(4);
+    EXPECT_EQ(popped, std::vector<int>({ 2, 3, 4, 8 }));
+    EXPECT_FALSE(ring.tryPop(value));
+
+    // a consumer keeping up keeps the mark low
+    kc::spscRing<int> drained(8);
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(drained.tryPush(i));
+        ASSERT_TRUE(drained.tryPop(value));
+    };
+    stats = drained.stats();
+    EXPECT_EQ(stats.depth, 0);
+    EXPECT_EQ(stats.highWaterMark, 1);
+
+    // ordering & counts across threads
+    constexpr int count = 100000;
+    kc::spscRing<int> queue(64);
+    std::thread producer([&queue]() {
+        for (int i = 0; i < count; i++) {
+            while (!queue.tryPush(i)) { std::this_thread::yield(); };
+        };
+    });
+    int expected = 0;
+    while (expected < count) {
+        if (queue.tryPop(value)) {
+            ASSERT_EQ(value, expected);
+            expected++;
+        };
+    };
+    producer.join();
+    EXPECT_LE(queue.stats().highWaterMark, 64);
+};
+
+TEST(tickerTest, tickShardsTest) {
+    namespace binary = kc::internal::binary;
+    constexpr size_t numberOfShards = 4;
+    std::vector<std::vector<kc::compactTick>> received(numberOfShards);
+    std::atomic<size_t> receivedCount { 0 };
+    kc::tickShards shards(
+        numberOfShards,
+        [&](size_t shard, kc::span<const kc::compactTick> ticks) {
+            received[shard].insert(
+                received[shard].end(), ticks.begin(), ticks.end());
+            receivedCount += ticks.size();
+        },
+        4096);
+    EXPECT_EQ(shards.size(), numberOfShards);
+
+    binary::frameGenerator generator;
+    std::vector<kc::compactTick> sent;
+    std::vector<kc::compactTick> ticks;
+    for (size_t i = 0; i < 10; i++) {
+        const std::vector<char>& frame = generator.next(100);
+        binary::parse(frame.data(), frame.size(), ticks);
+        shards.dispatch(kc::span<const kc::compactTick>(ticks));
+        sent.insert(sent.end(), ticks.begin(), ticks.end());
+    };
+    shards.stop();
+    ASSERT_EQ(receivedCount, sent.size());
+
+    // every shard sees its instruments' ticks in the order they were sent
+    std::vector<size_t> next(numberOfShards, 0);
+    for (const kc::compactTick& tick : sent) {
+        const size_t shard = shards.shardOf(tick.instrumentToken);
+        ASSERT_LT(next[shard], received[shard].size());
+        const kc::compactTick& got = received[shard][next[shard]++];
+        EXPECT_EQ(got.instrumentToken, tick.instrumentToken);
+        EXPECT_EQ(got.timestamp, tick.timestamp);
+        EXPECT_DOUBLE_EQ(got.lastPrice, tick.lastPrice);
+    };
+    for (size_t shard = 0; shard < numberOfShards; shard++) {
+        EXPECT_FALSE(received[shard].empty());
+        EXPECT_EQ(shards.getStats(shard).dropped, 0);
+    };
+};
+
+TEST(tickerTest, lastValueCacheTest) {
+    kc::lastValueCache cache(2);
+    kc::compactTick Tick;
+    EXPECT_FALSE(cache.get(408065, Tick));
+
+    Tick.instrumentToken = 408065;
+    Tick.lastPrice = 1299.05;
+    cache.update(Tick);
+    Tick.lastPrice = 1300;
+    cache.update(Tick);
+    Tick.instrumentToken = 2953217;
+    cache.update(Tick);
+    Tick.instrumentToken = 884737;
+    cache.update(Tick);
+    EXPECT_EQ(cache.getSize(), 2);
+    EXPECT_EQ(cache.getDropped(), 1);
+
+    kc::compactTick cached;
+    ASSERT_TRUE(cache.get(408065, cached));
+    EXPECT_DOUBLE_EQ(cached.lastPrice, 1300);
+    EXPECT_TRUE(cache.get(2953217, cached));
+    EXPECT_FALSE(cache.get(884737, cached));
+
+    // readers never see a partially written tick
+    constexpr int32_t updates = 20000;
+    kc::lastValueCache shared(16);
+    std::atomic<bool> done { false };
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 3; i++) {
+        readers.emplace_back([&shared, &done]() {
+            kc::compactTick read;
+            while (!done) {
+                if (!shared.get(1, read)) { continue; };
+                ASSERT_EQ(read.volumeTraded, read.lastTradedQuantity);
+                ASSERT_EQ(read.oi, read.volumeTraded);
+                ASSERT_EQ(read.marketDepth.sell[4].quantity, read.oi);
+            };
+        });
+    };
+    kc::compactTick written;
+    written.instrumentToken = 1;
+    for (int32_t i = 0; i < updates; i++) {
+        written.volumeTraded = written.lastTradedQuantity = written.oi =
+            written.marketDepth.sell[4].quantity = i;
+        shared.update(written);
+    };
+    done = true;
+    for (auto& reader : readers) { reader.join(); };
+};
+
+TEST(tickerTest, multicastRingTest) {
+    kc::multicastRing ring(3);
+    auto& first = ring.addConsumer();
+    auto& second = ring.addConsumer();
+    EXPECT_EQ(ring.getConsumerCount(), 2);
+
+    std::vector<kc::compactTick> ticks(3);
+    for (size_t i = 0; i < ticks.size(); i++) {
+        ticks[i].instrumentToken = static_cast<int32_t>(i);
+    };
+    EXPECT_TRUE(ring.publish(kc::span<const kc::compactTick>(ticks)));
+    EXPECT_THROW(ring.addConsumer(), kc::libException);
+
+    // consumers read the same slots in place
+    const kc::compactTick* firstSeen = nullptr;
+    EXPECT_EQ(first.tryConsume([&](kc::span<const kc::compactTick> batch) {
+        firstSeen = batch.data();
+    }),
+        3);
+    EXPECT_EQ(first.tryConsume([](kc::span<const kc::compactTick>) {}), 0);
+
+    // the slowest consumer holds back the producer
+    EXPECT_FALSE(ring.publish(kc::span<const kc::compactTick>(ticks)));
+    std::vector<int32_t> seen;
+    EXPECT_EQ(second.tryConsume([&](kc::span<const kc::compactTick> batch) {
+        EXPECT_EQ(batch.data(), firstSeen);
+        for (const auto& tick : batch) {
+            seen.push_back(tick.instrumentToken);
+        };
+    }),
+        3);
+    EXPECT_EQ(seen, std::vector<int32_t>({ 0, 1, 2 }));
+    EXPECT_TRUE(ring.publish(kc::span<const kc::compactTick>(ticks)));
+    kc::queueStats stats = ring.stats();
+    EXPECT_EQ(stats.capacity, 4);
+    EXPECT_EQ(stats.depth, 3);
+    EXPECT_EQ(stats.highWaterMark, 3);
+    EXPECT_EQ(stats.pushed, 6);
+    EXPECT_EQ(stats.dropped, 3);
+
+    // consumers keeping up keep the mark low
+    kc::multicastRing drained(8);
+    auto& only = drained.addConsumer();
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(
+            drained.publish(kc::span<const kc::compactTick>(ticks.data(), 1)));
+        EXPECT_EQ(only.tryConsume([](kc::span<const kc::compactTick>) {}), 1);
+    };
+    EXPECT_EQ(drained.stats().highWaterMark, 1);
+
+    // every consumer sees every tick in order, whatever the wait strategy
+    constexpr int32_t count = 20000;
+    for (const auto strategy : { kc::WAIT_STRATEGY::BUSY_SPIN,
+             kc::WAIT_STRATEGY::YIELD, kc::WAIT_STRATEGY::BLOCK }) {
+        kc::multicastRing shared(64, strategy);
+        std::vector<std::thread> consumers;
+        for (size_t i = 0; i < 3; i++) {
+            consumers.emplace_back([&consumer = shared.addConsumer(), count]() {
+                int32_t expected = 0;
+                while (consumer.consume(
+                           [&](kc::span<const kc::compactTick> batch) {
+                               for (const auto& tick : batch) {
+                                   ASSERT_EQ(tick.instrumentToken, expected);
+                                   expected++;
+                               };
+                           }) > 0) {};
+                EXPECT_EQ(expected, count);
+            });
+        };
+        kc::compactTick tick;
+        for (int32_t i = 0; i < count; i++) {
+            tick.instrumentToken = i;
+            while (!shared.publish(kc::span<const kc::compactTick>(&tick, 1))) {
+                std::this_thread::yield();
+            };
+        };
+        shared.close();
+        for (auto& consumer : consumers) { consumer.join(); };
+    };
+
+    // closing wakes up a consumer parked waiting for ticks
+    for (size_t round = 0; round < 100; round++) {
+        kc::multicastRing blocking(4, kc::WAIT_STRATEGY::BLOCK);
+        std::atomic<bool> returned { false };
+        std::thread parked([&consumer = blocking.addConsumer(), &returned]() {
+            EXPECT_EQ(consumer.consume([](kc::span<const kc::compactTick>) {}),
+                0);
+            returned = true;
+        });
+        if (round % 2 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        };
+        blocking.close();
+        parked.join();
+        EXPECT_TRUE(returned);
+    };
+};
+
+#if defined(KITEPP_HAS_SHM)
+TEST(tickerTest, sharedMemoryBusTest) {
+    const std::string name = "/kitepp-test-" + std::to_string(getpid());
+    EXPECT_THROW(kc::shmReader reader(name), kc::libException);
+
+    kc::shmPublisher publisher(name, 3);
+    EXPECT_EQ(publisher.getCapacity(), 4);
+    std::vector<kc::compactTick> ticks(10);
+    for (size_t i = 0; i < ticks.size(); i++) {
+        ticks[i].instrumentToken = static_cast<int32_t>(i);
+        ticks[i].lastPrice = static_cast<double>(i) + 0.05;
+    };
+    publisher.publish(kc::span<const kc::compactTick>(ticks.data(), 2));
+
+    // only ticks published after the reader maps the segment are read
+    kc::shmReader reader(name, 2);
+    std::vector<kc::compactTick> received;
+    reader.onTicks = [&](kc::shmReader* Reader,
+                         const std::vector<kc::compactTick>& Ticks) {
+        EXPECT_EQ(Reader, &reader);
+        EXPECT_LE(Ticks.size(), 2);
+        received.insert(received.end(), Ticks.begin(), Ticks.end());
+    };
+    EXPECT_EQ(reader.poll(), 0);
+    publisher.publish(kc::span<const kc::compactTick>(ticks.data() + 2, 3));
+    EXPECT_EQ(reader.poll(), 3);
+    ASSERT_EQ(received.size(), 3);
+    EXPECT_EQ(received[0].instrumentToken, 2);
+    EXPECT_DOUBLE_EQ(received[2].lastPrice, 4.05);
+
+    // a reader that falls behind skips overwritten ticks
+    received.clear();
+    publisher.publish(kc::span<const kc::compactTick>(ticks.data() + 5, 5));
+    EXPECT_EQ(reader.poll(), 4);
+    EXPECT_EQ(reader.getLost(), 1);
+    ASSERT_EQ(received.size(), 4);
+    EXPECT_EQ(received.front().instrumentToken, 6);
+    EXPECT_EQ(received.back().instrumentToken, 9);
+
+    // every tick reaches a reader running on another thread
+    constexpr int32_t count = 20000;
+    kc::shmPublisher shared(name + "-shared", count);
+    kc::shmReader runner(name + "-shared");
+    int32_t expected = 0;
+    runner.onTicks = [&](kc::shmReader* Reader,
+                         const std::vector<kc::compactTick>& Ticks) {
+        for (const auto& tick : Ticks) {
+            ASSERT_EQ(tick.instrumentToken, expected);
+            expected++;
+        };
+        if (expected == count) { Reader->stop(); };
+    };
+    std::thread thread([&runner]() { runner.run(); });
+    kc::compactTick tick;
+    for (int32_t i = 0; i < count; i++) {
+        tick.instrumentToken = i;
+        shared.publish(kc::span<const kc::compactTick>(&tick, 1));
+    };
+    thread.join();
+    EXPECT_EQ(runner.getLost(), 0);
+};
+#endif
+
+TEST(tickerTest, reconnectDelayTest) {
+    namespace utils = kc::internal::utils;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+    const auto delay = [](unsigned int attempt, double jitter) {
+        return utils::ws::reconnectDelay(
+            attempt, seconds(2), seconds(60), jitter);
+    };
+
+    EXPECT_EQ(delay(1, 0), milliseconds(1000));
+    EXPECT_EQ(delay(1, 0.5), milliseconds(1500));
+    EXPECT_EQ(delay(2, 0), milliseconds(2000));
+    EXPECT_EQ(delay(3, 0.999), milliseconds(7996));
+    // capped at the maximum delay, however many attempts were made
+    EXPECT_EQ(delay(6, 0), milliseconds(30000));
+    EXPECT_EQ(delay(1000, 0.9999), milliseconds(59997));
+};
+
+TEST(tickerTest, tickerPoolTest) {
+    EXPECT_THROW(kc::tickerPool("key", 0), kc::libException);
+    kc::tickerPool pool("key", 3);
+    EXPECT_EQ(pool.size(), 3);
+
+    // balanced by instrument count when modes are equal
+    pool.subscribe({ 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+    for (size_t connection = 0; connection < pool.size(); connection++) {
+        EXPECT_EQ(pool.getInstrumentCount(connection), 3);
+        EXPECT_EQ(pool.getLoad(connection), 3 * 44);
+    };
+
+    // and by mode weight otherwise
+    pool.subscribe({ 10 }, kc::MODE_FULL);
+    const size_t full = pool.getConnection(10).value();
+    EXPECT_EQ(pool.getLoad(full), (3 * 44) + 184);
+    pool.subscribe({ 11, 12, 13, 14 }, kc::MODE_QUOTE);
+    for (const int token : { 11, 12, 13, 14 }) {
+        EXPECT_NE(pool.getConnection(token).value(), full);
+    };
+
+    // changing the mode keeps the connection
+    const size_t connection = pool.getConnection(1).value();
+    const size_t load = pool.getLoad(connection);
+    pool.subscribe({ 1 }, kc::MODE_LTP);
+    EXPECT_EQ(pool.getConnection(1).value(), connection);
+    EXPECT_EQ(pool.getLoad(connection), load - 44 + 8);
+    EXPECT_THROW(pool.subscribe({ 1 }, "depth"), kc::libException);
+
+    pool.unsubscribe({ 1, 42 });
+    EXPECT_FALSE(pool.getConnection(1).has_value());
+
+    // instruments move to a connection with spare capacity
+    std::vector<int> emptied;
+    for (int token = 1; token <= 14; token++) {
+        if (pool.getConnection(token) == size_t(0)) {
+            emptied.push_back(token);
+        };
+    };
+    pool.unsubscribe(emptied);
+    EXPECT_EQ(pool.getInstrumentCount(0), 0);
+    const size_t instruments =
+        pool.getInstrumentCount(1) + pool.getInstrumentCount(2);
+    pool.rebalance(0);
+    EXPECT_GT(pool.getInstrumentCount(0), 0);
+    EXPECT_EQ(pool.getInstrumentCount(0) + pool.getInstrumentCount(1) +
+                  pool.getInstrumentCount(2),
+        instruments);
+    for (size_t a = 0; a < pool.size(); a++) {
+        for (size_t b = 0; b < pool.size(); b++) {
+            EXPECT_LE(pool.getLoad(a), pool.getLoad(b) + 184);
+        };
+    };
+
+    // can't exceed the per connection limit
+    std::vector<int> tokens(3 * kc::tickerPool::MAX_INSTRUMENTS_PER_CONNECTION);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        tokens[i] = static_cast<int>(i + 100);
+    };
+    EXPECT_THROW(pool.subscribe(tokens), kc::libException);
+    EXPECT_FALSE(pool.getConnection(100).has_value());
+};
+
+TEST(tickerTest, redundantTickerTest) {
+    kc::redundantTicker Ticker("key", 16);
+    EXPECT_THROW(Ticker.subscribe({ 408065 }, "invalid"), kc::libException);
+    Ticker.subscribe({ 408065 });
+    std::vector<std::pair<size_t, int32_t>> received;
+    Ticker.onTicks = [&](kc::redundantTicker*, size_t leg,
+                         kc::span<const kc::compactTick> ticks) {
+        for (const auto& tick : ticks) {
+            received.emplace_back(leg, tick.volumeTraded);
+        };
+    };
+    std::vector<kc::compactTick> ticks(2);
+    ticks[0].instrumentToken = 408065;
+    ticks[0].timestamp = 1625461887;
+    ticks[0].volumeTraded = 100;
+    ticks[1] = ticks[0];
+    ticks[1].volumeTraded = 150;
+
+    // the first copy wins, whichever leg it arrives on
+    Ticker.deliver(0, kc::span<const kc::compactTick>(ticks.data(), 1));
+    Ticker.deliver(1, kc::span<const kc::compactTick>(ticks));
+    Ticker.deliver(0, kc::span<const kc::compactTick>(ticks));
+    // older ticks arriving late are dropped too
+    ticks[0].timestamp--;
+    ticks[0].volumeTraded = 200;
+    Ticker.deliver(0, kc::span<const kc::compactTick>(ticks.data(), 1));
+    EXPECT_EQ(received, (std::vector<std::pair<size_t, int32_t>>(
+                            { { 0, 100 }, { 1, 150 } })));
+
+    // ltp ticks can't be told apart & come from one leg only
+    kc::compactTick ltp;
+    ltp.instrumentToken = 408065;
+    received.clear();
+    Ticker.deliver(0, kc::span<const kc::compactTick>(&ltp, 1));
+    Ticker.deliver(1, kc::span<const kc::compactTick>(&ltp, 1));
+    EXPECT_EQ(received.size(), 1);
+
+    kc::redundancyStats stats = Ticker.getStats();
+    EXPECT_EQ(stats.won[0] + stats.won[1], 3);
+    EXPECT_EQ(stats.duplicates, 5);
+    EXPECT_EQ(stats.untracked, 0);
+
+    // legs racing each other pass every tick on exactly once
+    constexpr int32_t count = 20000;
+    kc::redundantTicker racing("key", 4);
+    racing.subscribe({ 1 });
+    std::atomic<int32_t> passed { 0 };
+    racing.onTicks = [&](kc::redundantTicker*, size_t,
+                         kc::span<const kc::compactTick> Ticks) {
+        passed += static_cast<int32_t>(Ticks.size());
+    };
+    std::vector<std::thread> legs;
+    for (size_t leg = 0; leg < kc::redundantTicker::LEGS; leg++) {
+        legs.emplace_back([&racing, leg]() {
+            kc::compactTick tick;
+            tick.instrumentToken = 1;
+            tick.timestamp = 1;
+            for (int32_t i = 1; i <= count; i++) {
+                tick.volumeTraded = i;
+                racing.deliver(leg, kc::span<const kc::compactTick>(&tick, 1));
+            };
+        });
+    };
+    for (auto& leg : legs) { leg.join(); };
+    stats = racing.getStats();
+    EXPECT_EQ(passed, stats.won[0] + stats.won[1]);
+    EXPECT_EQ(stats.won[0] + stats.won[1] + stats.duplicates, 2 * count);
+    EXPECT_EQ(passed, count);
+
+    // slots of unsubscribed instruments are reused
+    kc::redundantTicker churning("key", 2);
+    kc::compactTick tick;
+    tick.timestamp = 1625461887;
+    tick.volumeTraded = 100;
+    for (int32_t token = 1; token <= 100; token++) {
+        churning.subscribe({ token });
+        tick.instrumentToken = token;
+        churning.deliver(0, kc::span<const kc::compactTick>(&tick, 1));
+        churning.deliver(1, kc::span<const kc::compactTick>(&tick, 1));
+        churning.unsubscribe({ token });
+    };
+    stats = churning.getStats();
+    EXPECT_EQ(stats.won[0], 100);
+    EXPECT_EQ(stats.duplicates, 100);
+    EXPECT_EQ(stats.untracked, 0);
+    // ticks of unsubscribed instruments aren't tracked
+    churning.deliver(0, kc::span<const kc::compactTick>(&tick, 1));
+    EXPECT_EQ(churning.getStats().untracked, 1);
+};
+
+TEST(tickerTest, subscribeFromAnyThreadTest) {
+    kc::ticker Ticker("key");
+    // without an I/O thread, commands run right away
+    std::future<void> sent = Ticker.subscribeAsync({ 408065 });
+    ASSERT_EQ(sent.wait_for(std::chrono::seconds(0)),
+        std::future_status::ready);
+    EXPECT_THROW(sent.get(), kc::libException);
+
+    // with one, they run on it
+    Ticker.startIoThread(0);
+    std::atomic<size_t> ranOnIoThread { 0 };
+    std::vector<std::thread> callers;
+    for (size_t i = 0; i < 4; i++) {
+        callers.emplace_back([&Ticker, &ranOnIoThread]() {
+            const auto caller = std::this_thread::get_id();
+            for (size_t j = 0; j < 100; j++) {
+                Ticker.post([&ranOnIoThread, caller](kc::ticker*) {
+                    if (std::this_thread::get_id() != caller) {
+                        ranOnIoThread++;
+                    };
+                });
+            };
+            // not connected, the error is passed back to the caller
+            EXPECT_THROW(Ticker.setMode(kc::MODE_FULL, { 408065 }),
+                kc::libException);
+            EXPECT_THROW(
+                Ticker.unsubscribeAsync({ 408065 }).get(), kc::libException);
+        });
+    };
+    for (auto& caller : callers) { caller.join(); };
+    Ticker.stop();
+    EXPECT_EQ(ranOnIoThread, 400);
+};
+
+TEST(tickerTest, externalLoopTest) {
+    kc::ticker Ticker("key");
+    EXPECT_GE(Ticker.getPollFd(), 0);
+    // nothing to do, returns right away
+    Ticker.poll();
+
+    Ticker.startIoThread(0);
+    EXPECT_THROW(Ticker.poll(), kc::libException);
+    Ticker.stop();
+};
+
+TEST(tickerTest, controlQueueTest) {
+    using std::chrono::milliseconds;
+    kc::internal::controlQueue control(2, 3);
+    std::vector<std::string> sent;
+    const auto send = [&sent](const std::string& frame) {
+        sent.push_back(frame);
+    };
+    const auto now = std::chrono::steady_clock::now();
+
+    // changes are merged, last one wins
+    control.subscribe({ 3, 1, 2 });
+    control.setMode(kc::MODE_FULL, { 1, 3 });
+    control.unsubscribe({ 2, 5 });
+    control.setMode(kc::MODE_LTP, { 3 });
+    EXPECT_FALSE(control.empty());
+    EXPECT_EQ(control.flush(now, send), milliseconds(1000));
+    EXPECT_EQ(sent, std::vector<std::string>({
+                        R"({"a":"unsubscribe","v":[2,5]})",
+                        R"({"a":"subscribe","v":[1,3]})",
+                        R"({"a":"mode","v":["full",[1]]})",
+                    }));
+
+    // the rest waits for the next window
+    sent.clear();
+    EXPECT_EQ(control.flush(now + milliseconds(400), send), milliseconds(600));
+    EXPECT_TRUE(sent.empty());
+    EXPECT_EQ(control.flush(now + milliseconds(1000), send), milliseconds(0));
+    EXPECT_EQ(sent,
+        std::vector<std::string>({ R"({"a":"mode","v":["ltp",[3]]})" }));
+    EXPECT_TRUE(control.empty());
+
+    // thousands of tokens go out in a few frames
+    sent.clear();
+    kc::internal::controlQueue large;
+    std::vector<int> tokens(3000);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        tokens[i] = static_cast<int>(i);
+    };
+    large.subscribe(tokens);
+    large.setMode(kc::MODE_FULL, tokens);
+    EXPECT_EQ(large.flush(now, send), milliseconds(0));
+    EXPECT_EQ(sent.size(), 6);
+    EXPECT_EQ(sent[3].rfind(R"({"a":"mode","v":["full",[0,1,2,)", 0), 0);
+
+    // resubscribing before an unsubscribe is sent resets the mode
+    sent.clear();
+    large.unsubscribe({ 7 });
+    large.subscribe({ 7 });
+    EXPECT_EQ(large.flush(now + milliseconds(1000), send), milliseconds(0));
+    EXPECT_EQ(sent, std::vector<std::string>({
+                        R"({"a":"subscribe","v":[7]})",
+                        R"({"a":"mode","v":["quote",[7]]})",
+                    }));
+
+    control.subscribe({ 1 });
+    control.clear();
+    EXPECT_TRUE(control.empty());
+    EXPECT_THROW(control.setLimits(0, 1), kc::libException);
+};
+
+TEST(tickerTest, subscriptionTableTest) {
+    namespace internal = kc::internal;
+    internal::subscriptionTable table;
+    EXPECT_EQ(table.find(408065), internal::tokenIndex::NOT_FOUND);
+
+    const uint32_t first = table.add(408065);
+    table.mode(first) = kc::TICK_MODE::FULL;
+    table.refCount(first) = 2;
+    EXPECT_EQ(table.add(408065), first);
+    const uint32_t second = table.add(884737);
+    table.mode(second) = kc::TICK_MODE::LTP;
+    EXPECT_EQ(table.size(), 2);
+
+    // the last slot moves into the freed one, taking its state along
+    EXPECT_TRUE(table.remove(408065));
+    EXPECT_FALSE(table.remove(408065));
+    ASSERT_EQ(table.find(884737), 0);
+    EXPECT_EQ(table.mode(0), kc::TICK_MODE::LTP);
+    EXPECT_EQ(table.refCount(0), 0);
+    EXPECT_EQ(table.getTokens(), std::vector<int32_t>({ 884737 }));
+
+    // matches a map through growth & removals
+    internal::tokenIndex index;
+    std::unordered_map<int32_t, bool> expected;
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < 20000; i++) {
+        state ^= state << 13U;
+        state ^= state >> 7U;
+        state ^= state << 17U;
+        const auto token = static_cast<int32_t>(state % 512);
+        if ((state >> 32U) % 3 == 0) {
+            EXPECT_EQ(index.erase(token) != internal::tokenIndex::NOT_FOUND,
+                expected.erase(token) == 1);
+        } else {
+            EXPECT_EQ(index.insert(token).second, expected.count(token) == 0);
+            expected[token] = true;
+        };
+    };
+    ASSERT_EQ(index.size(), expected.size());
+    for (uint32_t slot = 0; slot < index.size(); slot++) {
+        EXPECT_EQ(index.find(index.token(slot)), slot);
+        EXPECT_EQ(expected.count(index.token(slot)), 1);
+    };
+};
+
+TEST(tickerTest, subscriberRegistryTest) {
+    namespace internal = kc::internal;
+    using Tokens = std::vector<int>;
+    constexpr auto LTP = static_cast<size_t>(kc::TICK_MODE::LTP);
+    constexpr auto FULL = static_cast<size_t>(kc::TICK_MODE::FULL);
+    internal::subscriberRegistry registry;
+
+    // the first subscriber subscribes, `quote` needs no mode frame
+    internal::subscriptionChanges changes =
+        registry.request(1, { 408065, 884737 }, kc::TICK_MODE::QUOTE);
+    EXPECT_EQ(changes.subscribed, Tokens({ 408065, 884737 }));
+    EXPECT_TRUE(changes.modes[LTP].empty() && changes.modes[FULL].empty());
+
+    // others only raise the mode
+    changes = registry.request(2, { 408065 }, kc::TICK_MODE::LTP);
+    EXPECT_TRUE(changes.empty());
+    changes = registry.request(3, { 408065 }, kc::TICK_MODE::FULL);
+    EXPECT_TRUE(changes.subscribed.empty());
+    EXPECT_EQ(changes.modes[FULL], Tokens({ 408065 }));
+    EXPECT_TRUE(registry.request(3, { 408065 }, kc::TICK_MODE::FULL).empty());
+    const internal::subscriptionTable& table = registry.getTable();
+    EXPECT_EQ(table.refCount(table.find(408065)), 3);
+
+    // unsubscribing lowers the mode to what is still needed
+    changes = registry.release(3, { 408065 });
+    EXPECT_TRUE(changes.unsubscribed.empty());
+    EXPECT_EQ(changes.modes[static_cast<size_t>(kc::TICK_MODE::QUOTE)],
+        Tokens({ 408065 }));
+    changes = registry.release(1, { 408065, 999 });
+    EXPECT_EQ(changes.modes[LTP], Tokens({ 408065 }));
+    EXPECT_EQ(table.mode(table.find(408065)), kc::TICK_MODE::LTP);
+    EXPECT_EQ(table.refCount(table.find(408065)), 1);
+    EXPECT_TRUE(registry.release(3, { 408065 }).empty());
+
+    // until nobody needs the instrument
+    changes = registry.releaseAll(2);
+    EXPECT_EQ(changes.unsubscribed, Tokens({ 408065 }));
+    EXPECT_EQ(table.find(408065), internal::tokenIndex::NOT_FOUND);
+    changes = registry.releaseAll(1);
+    EXPECT_EQ(changes.unsubscribed, Tokens({ 884737 }));
+    EXPECT_TRUE(registry.empty());
+
+    // a new instrument asked for in `ltp` is subscribed, then its mode set
+    changes = registry.request(4, { 256265 }, kc::TICK_MODE::LTP);
+    EXPECT_EQ(changes.subscribed, Tokens({ 256265 }));
+    EXPECT_EQ(changes.modes[LTP], Tokens({ 256265 }));
+    EXPECT_EQ(internal::toTickMode(kc::MODE_FULL), kc::TICK_MODE::FULL);
+    EXPECT_EQ(internal::modeName(kc::TICK_MODE::LTP), kc::MODE_LTP);
+    EXPECT_THROW(internal::toTickMode("fast"), kc::libException);
+};
+
+TEST(tickerTest, textMessageParserTest) {
+    namespace utils = kc::internal::utils;
+    kc::internal::textMessageParser parser;
+    const std::string message =
+        R"({"type":"order","data":{"order_id":"220303000308932",)"
+        R"("exchange_order_id":null,"status":"COMPLETE","quantity":2,)"
+        R"("filled_quantity":2,"unfilled_quantity":0,"price":0,)"
+        R"("average_price":470.5,"meta":{"quantity":"x"},"tags":["a",1],)"
+        R"("tradingsymbol":"SBIN",)"
+        R"("exchange_timestamp":"2022-03-03 09:24:25"}})";
+
+    // matches the DOM based parser
+    rapidjson::Document res;
+    utils::json::parse(res, message);
+    const kc::postback expected(utils::json::extractObject(res));
+    parser.parse(message.data(), message.size());
+    EXPECT_EQ(parser.getType(), "order");
+    const kc::postback& Postback = parser.getPostback();
+    EXPECT_EQ(Postback.orderId, expected.orderId);
+    EXPECT_EQ(Postback.exchangeOrderId, "");
+    EXPECT_EQ(Postback.status, expected.status);
+    EXPECT_EQ(Postback.tradingSymbol, expected.tradingSymbol);
+    EXPECT_EQ(Postback.exchangeTimestamp, expected.exchangeTimestamp);
+    EXPECT_EQ(Postback.quantity, expected.quantity);
+    EXPECT_EQ(Postback.filledQuantity, expected.filledQuantity);
+    EXPECT_DOUBLE_EQ(Postback.averagePrice, expected.averagePrice);
+    EXPECT_DOUBLE_EQ(Postback.triggerPrice, expected.triggerPrice);
+    EXPECT_EQ(Postback.product, expected.product);
+
+    // the buffer & postback are reused
+    const std::string error = R"({"data":"invalid token","type":"error"})";
+    parser.parse(error.data(), error.size());
+    EXPECT_EQ(parser.getType(), "error");
+    EXPECT_EQ(parser.getData(), "invalid token");
+    EXPECT_THROW(parser.getPostback(), kc::libException);
+
+    const std::string mistyped = R"({"type":"order","data":{"quantity":1.5}})";
+    EXPECT_THROW(
+        parser.parse(mistyped.data(), mistyped.size()), kc::libException);
+    EXPECT_THROW(parser.parse("[1]", 3), kc::libException);
+    EXPECT_THROW(parser.parse("{", 1), kc::libException);
+};
+
+TEST(tickerTest, orderBookTest) {
+    kc::orderBook book(4);
+    kc::orderState Order;
+    kc::postback open;
+    open.orderId = "220303000308932";
+    open.status = "OPEN";
+    open.exchangeTimestamp = "2022-03-03 09:24:25";
+    open.quantity = 10;
+    open.unfilledQuantity = 10;
+    EXPECT_FALSE(book.get(open.orderId, Order));
+    EXPECT_TRUE(book.update(open));
+    ASSERT_TRUE(book.get(open.orderId, Order));
+    EXPECT_EQ(kc::orderState::text(Order.status), "OPEN");
+    EXPECT_EQ(Order.pendingQuantity, 10);
+
+    // duplicates & updates older than the current state are dropped
+    kc::postback partial = open;
+    partial.status = "UPDATE";
+    partial.filledQuantity = 4;
+    partial.unfilledQuantity = 6;
+    EXPECT_TRUE(book.update(partial));
+    EXPECT_FALSE(book.update(partial));
+    EXPECT_FALSE(book.update(open));
+    kc::postback older = open;
+    older.status = "OPEN PENDING";
+    older.exchangeTimestamp = "2022-03-03 09:24:24";
+    EXPECT_FALSE(book.update(older));
+    EXPECT_EQ(book.getStale(), 3);
+
+    // nothing changes once the order is complete
+    kc::postback complete = partial;
+    complete.status = kc::STATUS_COMPLETE;
+    complete.filledQuantity = 10;
+    complete.unfilledQuantity = 0;
+    complete.averagePrice = 470.5;
+    complete.exchangeTimestamp = "2022-03-03 09:24:26";
+    EXPECT_TRUE(book.update(complete));
+    kc::postback cancelled = complete;
+    cancelled.status = kc::STATUS_CANCELLED;
+    cancelled.exchangeTimestamp = "2022-03-03 09:25:00";
+    EXPECT_FALSE(book.update(cancelled));
+    ASSERT_TRUE(book.get(open.orderId, Order));
+    EXPECT_TRUE(Order.isFinal());
+    EXPECT_EQ(Order.filledQuantity, 10);
+    EXPECT_DOUBLE_EQ(Order.averagePrice, 470.5);
+
+    // bootstrapped from `kite::orders()`, up to the book's capacity
+    std::vector<kc::order> Orders(5);
+    for (size_t i = 0; i < Orders.size(); i++) {
+        Orders[i].orderID = std::to_string(100 + i);
+        Orders[i].status = "OPEN";
+    };
+    book.load(Orders);
+    EXPECT_EQ(book.getSize(), 4);
+    EXPECT_EQ(book.getDropped(), 2);
+    ASSERT_TRUE(book.get("102", Order));
+    EXPECT_EQ(kc::orderState::text(Order.orderId), "102");
+    EXPECT_FALSE(book.get("104", Order));
+    EXPECT_THROW(kc::orderBook(0), kc::libException);
+};
+
+TEST(tickerTest, vectorizedDecodersTest) {
+    namespace binary = kc::internal::binary;
+    std::vector<char> data = loadSampleFrame();
+    ASSERT_FALSE(data.empty());
+
+    std::vector<std::pair<binary::quoteHeaderDecoder, binary::depthDecoder>>
+        decoders;
+#ifdef KITEPP_X86_SIMD
+    if (__builtin_cpu_supports("ssse3")) {
+        decoders.emplace_back(
+            binary::ssse3::decodeQuoteHeader, binary::ssse3::decodeDepth);
+    };
+    if (__builtin_cpu_supports("avx2")) {
+        decoders.emplace_back(
+            binary::avx2::decodeQuoteHeader, binary::avx2::decodeDepth);
+    };
+#endif
+
+    for (const auto& packet : binary::frameView(data.data(), data.size())) {
+        ASSERT_EQ(packet.size(), binary::layout::full::SIZE);
+        const char* depth = packet.data() + binary::layout::full::DEPTH;
+        const double divisor = binary::priceDivisor(packet.get<int32_t>(0));
+        binary::quoteHeader expectedHeader;
+        std::vector<kc::depthWS> expectedDepth(10);
+        binary::scalar::decodeQuoteHeader(
+            packet.data(), divisor, expectedHeader);
+        binary::scalar::decodeDepth(depth, divisor, expectedDepth.data(),
+            expectedDepth.data() + 5);
+
+        for (const auto& [decodeQuoteHeader, decodeDepth] : decoders) {
+            binary::quoteHeader header;
+            std::vector<kc::depthWS> depthEntries(10);
+            decodeQuoteHeader(packet.data(), divisor, header);
+            decodeDepth(
+                depth, divisor, depthEntries.data(), depthEntries.data() + 5);
+
+            EXPECT_EQ(header.instrumentToken, expectedHeader.instrumentToken);
+            EXPECT_EQ(header.lastTradedQuantity,
+                expectedHeader.lastTradedQuantity);
+            EXPECT_EQ(header.volumeTraded, expectedHeader.volumeTraded);
+            EXPECT_EQ(
+                header.totalBuyQuantity, expectedHeader.totalBuyQuantity);
+            EXPECT_EQ(
+                header.totalSellQuantity, expectedHeader.totalSellQuantity);
+            EXPECT_EQ(header.prices, expectedHeader.prices);
+            for (size_t i = 0; i < depthEntries.size(); i++) {
+                EXPECT_EQ(depthEntries[i].orders, expectedDepth[i].orders);
+                EXPECT_EQ(depthEntries[i].quantity, expectedDepth[i].quantity);
+                EXPECT_EQ(depthEntries[i].price, expectedDepth[i].price);
+            };
+        };
+    };
+};
 } // namespace kiteconnect